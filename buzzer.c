@@ -31,39 +31,126 @@
 #include "buzzer.h"
 #include "config.h"
 
+
+// BEEP peripheral is used for tones only when PD4 alternate function
+//   is set to BEEP (option byte OPT2 AFR7), else buzzer is only
+//   switched on/off as before
+#define OPT2  (*(volatile u8 *)0x4803)
+#define BEEP_DIV  14		// LSI 128kHz / (8 * (14+2)) = 1kHz
+static _Bool buzzer_beep;	// 1 when BEEP peripheral is on PD4
+// BEEP_CSR values for tones
+static const u8 buzzer_csr[4] = {
+    BEEP_DIV,			// off
+    0b00100000 | BEEP_DIV,	// 1kHz
+    0b01100000 | BEEP_DIV,	// 2kHz
+    0b10100000 | BEEP_DIV	// 4kHz
+};
+
+
 /** @brief
  *    buzzer initialization
  */
 void buzzer_init(void) {
     IO_OP(D, 4);	// buzzer pin
     BUZZER0;		// stop buzzer
+    if (OPT2 & 0x80) {
+	// BEEP is clocked from LSI
+	BSET(CLK_ICKR, 3);
+	while (!BCHK(CLK_ICKR, 4)) {}  // wait for LSI ready
+	BEEP_CSR = buzzer_csr[0];
+	buzzer_beep = 1;
+    }
 }
 
 
+// buzzer patterns, each byte is tone in bits 7-6 and length in 5ms
+//   in bits 5-0, 0 ends pattern
+const u8 buzzer_key[] = { BZ_HIGH | 1, 0 };
+const u8 buzzer_alarm[] = {
+    BZ_HIGH | 20, BZ_MID | 20, BZ_HIGH | 20, 0
+};
+const u8 buzzer_battery[] = {
+    BZ_LOW | 40, BZ_OFF | 63, BZ_OFF | 63, BZ_OFF | 34, 0
+};
+const u8 buzzer_inactivity[] = {
+    BZ_MID | 10, BZ_OFF | 10, BZ_MID | 10,
+    BZ_OFF | 63, BZ_OFF | 63, BZ_OFF | 63, BZ_OFF | 63, BZ_OFF | 4, 0
+};
+
+
 // buzzer counters and flags
 _Bool buzzer_running;	// 1 when running
-u8 buzzer_cnt_on;	// time to be ON
-u8 buzzer_cnt_off;	// time to be OFF
-u16 buzzer_count;	// length of beeping
-u8 buzzer_cnt;		// helper counter
+u8 buzzer_cnt;		// 5ms steps to next pattern byte
+static u16 buzzer_count;	// number of pattern repeats
+static const u8 *buzzer_pattern;	// actual pattern
+static const u8 *buzzer_ptr;	// next byte of pattern
+static u8 buzzer_ram[11];	// pattern for buzzer_on(), 2 * 5 + 1
 
 
-// more beeps: on time, off time and count of beeps
-void buzzer_on(u8 on_5ms, u8 off_5ms, u16 count) {
-    buzzer_cnt_on = buzzer_cnt = on_5ms;
-    buzzer_cnt_off = off_5ms;
+// set tone, 0 is off
+static void buzzer_tone(u8 tone) {
+    if (buzzer_beep)  BEEP_CSR = buzzer_csr[tone];
+    else if (tone)  BUZZER1;
+    else  BUZZER0;
+}
+
+
+// go to next pattern byte, called from timer interrupt when buzzer_cnt
+//   counts to 0
+void buzzer_step(void) {
+    u8 b = *buzzer_ptr++;
+    if (!b) {
+	// end of pattern
+	if (!--buzzer_count) {
+	    buzzer_off();
+	    return;
+	}
+	buzzer_ptr = buzzer_pattern;
+	b = *buzzer_ptr++;
+    }
+    buzzer_tone((u8)(b >> 6));
+    buzzer_cnt = (u8)(b & 0x3f);
+}
+
+
+// play pattern count times
+void buzzer_play(const u8 *pattern, u16 count) {
+    buzzer_running = 0;		// stop stepping in timer interrupt
+    buzzer_pattern = buzzer_ptr = pattern;
     buzzer_count = count;
-    BUZZER1;
+    buzzer_step();
     buzzer_running = 1;
 }
 
 
+// add pattern bytes for given length
+static u8 *buzzer_len(u8 *p, u8 tone, u8 len) {
+    while (len > 63) {
+	*p++ = (u8)(tone | 63);
+	len -= 63;
+    }
+    if (len)  *p++ = (u8)(tone | len);
+    return p;
+}
+
+
+// more beeps: on time, off time and count of beeps
+void buzzer_on(u8 on_5ms, u8 off_5ms, u16 count) {
+    u8 *p;
+    buzzer_running = 0;		// buzzer_ram will be changed
+    p = buzzer_len(buzzer_ram, BZ_MID, on_5ms);
+    p = buzzer_len(p, BZ_OFF, off_5ms);
+    *p = 0;
+    buzzer_play(buzzer_ram, count);
+}
+
+
 /// @brief
 ///    stop buzzer
 ///
 void buzzer_off(void) {
-    BUZZER0;
     buzzer_running = 0;
+    buzzer_tone(0);
 }
 
 
@@ -76,6 +163,5 @@ void beep(u8 len_5ms) {
 
 // key beep if enabled in config
 void key_beep(void) {
-    if (cg.key_beep)  beep(1);
+    if (cg.key_beep && !buzzer_running)  buzzer_play(buzzer_key, 1);
 }
-
@@ -31,22 +31,34 @@
 
 
 
+// tones in buzzer patterns
+#define BZ_OFF   0x00
+#define BZ_LOW   0x40
+#define BZ_MID   0x80
+#define BZ_HIGH  0xc0
+
+
+
 // functions to use
 #define BUZZER_MAX (u16)(0xffff)
 extern void buzzer_on(u8 on_5ms, u8 off_5ms, u16 count);
+extern void buzzer_play(const u8 *pattern, u16 count);
 extern void buzzer_off(void);
 extern void beep(u8 len_5ms);
 extern void key_beep(void);
 
+// patterns for buzzer_play()
+extern const u8 buzzer_key[];
+extern const u8 buzzer_alarm[];
+extern const u8 buzzer_battery[];
+extern const u8 buzzer_inactivity[];
+
 
 
 // variables used at timer
 extern _Bool buzzer_running;
-extern u8 buzzer_cnt_on;
-extern u8 buzzer_cnt_off;
-extern u16 buzzer_count;
 extern u8 buzzer_cnt;
+extern void buzzer_step(void);
 
 
 #endif
-
@@ -18,12 +18,14 @@
 
 
 
+#include <string.h>
 #include "calc.h"
 #include "menu.h"
 #include "ppm.h"
 #include "config.h"
 #include "input.h"
 #include "timer.h"
+#include "ppm_in.h"
 
 
 
@@ -32,6 +34,72 @@
 
 @near static s16 last_value[MAX_CHANNELS];
 
+// servo speeds as rates in PPM units per 1ms (8.8 fixed point), they are
+//   recomputed only when speed setting changes
+#define RATE_TURN	MAX_CHANNELS
+#define RATE_RETURN	(MAX_CHANNELS + 1)
+#define RATE_ACCEL_FWD	(MAX_CHANNELS + 2)
+#define RATE_ACCEL_BRK	(MAX_CHANNELS + 3)
+#define RATE_NUM	(MAX_CHANNELS + 4)
+#define RATE_MAX_MS	50
+@near static u8  rate_speed[RATE_NUM];
+@near static u16 rate_value[RATE_NUM];
+static u16 calc_time_ms;	// time of previous calc_loop
+static u8  calc_elapsed;	// ms elapsed from previous calc_loop
+
+// programmable mixes prepared from cm.mix, rates are multipliers
+//   in 2.14 fixed point, so each line is one multiply without division
+#define MIX_SHIFT	14
+#define MIX_SW_REV	0x80
+#define MIX_SW_LSW	0x40
+#define MIX_SRC_IN	0x80
+typedef struct {
+    u8	src;		// source channel - 1 or MIX_SRC_IN + PPM input
+    u8	dst;		// destination channel - 1
+    u8	sw;		// 0 always or switch channel or MIX_SW_LSW + logical
+			//   switch, MIX_SW_REV at - side or switch off
+    s16	mul[2];		// for negative/positive source side
+    s16	offset;
+} mix_line_s;
+@near static mix_line_s mix_line[MIX_LINES];
+static u8 mix_lines;		// number of used lines
+static u8 mix_channels;		// channels 3-8 with mixes added
+@near static s16 mix_value[MAX_CHANNELS];	// sum of mixes to channels
+
+// curves prepared from cm.curve, slopes of segments in 5.11 fixed point,
+//   evaluation is segment select and one multiply
+#define CURVE_SHIFT	11
+#define CURVE_SEG	PPM(125)	// CRV segment width
+typedef struct {
+    s16	slope[CURVE_POINTS - 1];	// CRV segments or 2 ARC segments
+    s16	arc_x;			// ARC break point
+    s16	arc_y;
+} curve_s;
+@near static curve_s curve_data[2];
+
+// logical switches, one bit for each, tested by mixes
+u8 calc_switches;
+
+// set during model change, last PPM values are repeated
+_Bool calc_hold;
+
+// ABS pulses are stepped every 1ms at timer interrupt, CALC only sets
+//   calc_abs_brake when brake is over trigger point and applies abs_mul
+//   when brake is reduced
+volatile u8 calc_abs_brake;	// brake over trigger point
+static _Bool abs_running;
+static volatile _Bool abs_reduce;	// brake reduced now
+static u16 abs_cnt;		// ms to next change
+@near static u16 abs_ms[3];	// first full brake with delay, full, reduced
+static u16 abs_mul;		// multiplier of reduced brake, 8.8
+static s16 abs_trigger;
+
+// PPM input mapped to output channels, ppm_in_active is set each cycle
+//   only when input signal is valid
+@near static u8 ppm_in_src[MAX_CHANNELS];	// input - 1 for each output
+static u8 ppm_in_outputs;	// output channels mapped to input
+static u8 ppm_in_active;
+
 
 
 
@@ -46,6 +114,7 @@ void calc_init(void) {
     build(CALC);
     activate(CALC, calc_loop);
     sleep(CALC);	// no work yet, waked up after setting number of channels
+    memset(rate_speed, 0xff, sizeof(rate_speed));	// no rates computed
 }
 
 
@@ -82,6 +151,9 @@ static void channel_params(u8 channel, s16 inval) {
     // if value forced from menu (settting endpoints, subtrims, ...), set it
     if (menu_force_value_channel == channel)
 	inval = menu_force_value;
+    // channel mapped to PPM input
+    else if (ppm_in_active && (ppm_in_active & (u8)(1 << (channel - 1))))
+	inval = ppm_in[ppm_in_src[channel - 1]];
     
     // check limits -5000..5000
     if (inval < PPM(-500))       inval = PPM(-500);
@@ -143,13 +215,269 @@ static s16 expo(s16 inval, s8 exp) {
 }
 
 
+// max value change during elapsed time for given speed 0..99
+static s16 speed_delta(u8 idx, u8 speed) {
+    if (speed != rate_speed[idx]) {
+	rate_speed[idx] = speed;
+	rate_value[idx] = (u16)((u16)(PPM(1000) / 2 / 20) * 256
+				 / (u8)(100 - speed));
+    }
+    return (s16)(((u32)rate_value[idx] * calc_elapsed) >> 8);
+}
+
+
+// prepare programmable mixes from model config, mixes to channels
+//   already mixed (4WS, DIG, brake) are skipped
+void calc_mix_prepare(u8 mixed) {
+    config_mix_s *m = cm.mix;
+    mix_line_s *l = mix_line;
+    u8 i, bit;
+
+    mix_lines = 0;
+    mix_channels = 0;
+    for (i = 0; i < MIX_LINES; i++, m++) {
+	if (!m->dst || m->dst > channels || !m->src ||
+	    (m->src > channels && m->src <= MAX_CHANNELS) ||
+	    m->src > MAX_CHANNELS + PPM_IN_MIX)
+	    continue;
+	bit = (u8)(1 << (m->dst - 1));
+	if (m->dst > 2) {
+	    if (mixed & bit)  continue;
+	    mix_channels |= bit;
+	}
+	// channels are 1..8, PPM inputs 9..
+	if (m->src > MAX_CHANNELS)
+	    l->src = (u8)(MIX_SRC_IN | (m->src - MAX_CHANNELS - 1));
+	else  l->src = (u8)(m->src - 1);
+	l->dst = (u8)(m->dst - 1);
+	// switch channels are 1..8, logical switches 9..
+	bit = (u8)(m->sw < 0 ? -m->sw : m->sw);
+	if (bit > MAX_CHANNELS)  bit = (u8)(MIX_SW_LSW | (bit - MAX_CHANNELS - 1));
+	if (m->sw < 0)  bit |= MIX_SW_REV;
+	l->sw = bit;
+	l->mul[0] = (s16)((s32)m->rate[0] * ((s32)1 << MIX_SHIFT) / 100);
+	l->mul[1] = (s16)((s32)m->rate[1] * ((s32)1 << MIX_SHIFT) / 100);
+	l->offset = m->offset * PPM(5);
+	l++;
+	mix_lines++;
+    }
+}
+
+
+// prepare slopes of steering and throttle curves from model config
+void calc_curve_prepare(void) {
+    config_curve_s *c = cm.curve;
+    curve_s *d = curve_data;
+    u8 i, j;
+
+    for (i = 0; i < 2; i++, c++, d++) {
+	// CRV, PPM(5) * 2^CURVE_SHIFT / CURVE_SEG is 8.192
+	for (j = 0; j < CURVE_POINTS - 1; j++)
+	    d->slope[j] = (s16)((s32)(c->point[j + 1] - c->point[j])
+				* (1 << CURVE_SHIFT) / 25);
+	// ARC uses slope[0] and slope[1] when it is selected
+	if ((i ? cm.curve_throttle : cm.curve_steering) != CURVE_ARC)
+	    continue;
+	d->arc_x = c->arc_x * PPM(5);
+	d->arc_y = c->arc_y * PPM(5);
+	d->slope[0] = (s16)(((s32)c->arc_y << CURVE_SHIFT) / c->arc_x);
+	d->slope[1] = (s16)(((s32)(100 - c->arc_y) << CURVE_SHIFT)
+			    / (100 - c->arc_x));
+    }
+}
+
+
+// apply curve: inval -5000..5000
+static s16 curve(u8 id, u8 type, s16 inval) {
+    curve_s *d = &curve_data[id];
+    s8 *point = cm.curve[id].point;
+    s16 x = PPM(-500) + CURVE_SEG;
+    u8 seg = 0;
+    u8 neg;
+    s16 val;
+
+    if (type == CURVE_CRV) {
+	// select segment and interpolate
+	while (seg < CURVE_POINTS - 2 && inval >= x) {
+	    seg++;
+	    x += CURVE_SEG;
+	}
+	return point[seg] * PPM(5) +
+	    (s16)(((s32)(inval - x + CURVE_SEG) * d->slope[seg]) >> CURVE_SHIFT);
+    }
+
+    // ARC, the same for both sides
+    neg = (u8)(inval < 0 ? 1 : 0);
+    if (neg)  inval = -inval;
+    if (inval < d->arc_x)
+	val = (s16)(((s32)inval * d->slope[0]) >> CURVE_SHIFT);
+    else
+	val = d->arc_y + (s16)(((s32)(inval - d->arc_x) * d->slope[1])
+			       >> CURVE_SHIFT);
+    return neg ? -val : val;
+}
+
+
+// prepare mapping of PPM input to output channels
+void calc_ppm_in_prepare(void) {
+    u8 i, in;
+
+    ppm_in_outputs = 0;
+    for (i = 0; i < channels; i++) {
+	in = (u8)((cm.ppm_in_map[i >> 1] >> ((i & 1) << 2)) & 0x0f);
+	if (!in)  continue;
+	ppm_in_src[i] = (u8)(in - 1);
+	ppm_in_outputs |= (u8)(1 << i);
+    }
+}
+
+
+// prepare ABS times and values from model config
+void calc_abs_prepare(void) {
+    // SLO/NOR/FAS are cycle rates 10/20/30
+    u8 rate = (u8)(cm.abs_cycle ? cm.abs_cycle : cm.abs_type * 10);
+    // 240ms cycle at rate 10, 160 at 20, 120 at 30
+    u16 cycle = 4800 / (rate + 10);
+    u16 reduced = (u16)(cycle * (u8)(5 - cm.abs_duty) / 10);
+
+    sim();
+    abs_ms[2] = reduced;
+    abs_ms[1] = cycle - reduced;
+    abs_ms[0] = abs_ms[1] + cm.abs_delay * 100;
+    rim();
+    abs_mul = (u16)(256 - (u16)(50 + cm.abs_return) * 256 / 100);
+    abs_trigger = cm.abs_trigger ? cm.abs_trigger * PPM(5) : ABS_THRESHOLD;
+}
+
+
+// step ABS, called every 1ms from timer interrupt when ABS is on
+void calc_abs_tick(void) {
+    if (!calc_abs_brake) {
+	abs_running = 0;
+	abs_reduce = 0;
+	return;
+    }
+    if (!abs_running) {
+	// start with full brake after onset delay
+	abs_running = 1;
+	abs_cnt = abs_ms[0];
+	return;
+    }
+    if (--abs_cnt)  return;
+    abs_reduce ^= 1;
+    abs_cnt = abs_ms[abs_reduce ? 2 : 1];
+}
+
+
+#ifdef CALC_BENCH
+u16 calc_bench_last, calc_bench_max;
+
+static u16 bench_tim2(void) {
+    u8 hi = TIM2_CNTRH;		// reading high byte latches low byte
+    return (u16)((u16)hi << 8 | TIM2_CNTRL);
+}
+#endif
+
+// evaluate logical switches, switches can use results of previous
+//   ones from this frame and of next ones from previous frame
+static void switches_evaluate(s16 steering, s16 throttle) {
+    config_lsw_s *l = cm.lsw;
+    u8 sw = calc_switches;
+    u8 i, bit, on;
+    s16 val;
+
+    for (i = 0, bit = 1; i < LSW_NUM; i++, l++, bit <<= 1) {
+	switch (l->func) {
+	    case LSW_GT:
+	    case LSW_LT:
+		if (l->a > 2)	    val = menu_channel3_8[l->a - 3] * PPM(5);
+		else if (l->a == 2) val = throttle;
+		else		    val = steering;
+		if (l->func == LSW_GT)  on = (u8)(val > l->val * PPM(5));
+		else			on = (u8)(val < l->val * PPM(5));
+		break;
+	    case LSW_KEY:
+		on = (u8)(buttons_state & ((u16)1 << l->a) ? 1 : 0);
+		break;
+	    case LSW_TIMER:
+		on = (u8)(menu_timer_alarmed & (u8)(1 << l->a) ? 1 : 0);
+		break;
+	    case LSW_AND:
+		on = (u8)((sw & (u8)(1 << l->a)) && (sw & (u8)(1 << l->b)));
+		break;
+	    case LSW_OR:
+		on = (u8)((sw & (u8)(1 << l->a)) || (sw & (u8)(1 << l->b)));
+		break;
+	    default:
+		on = 0;
+	}
+	if (l->inv)  on ^= 1;
+	if (on)  sw |= bit;
+	else	 sw &= (u8)~bit;
+    }
+    calc_switches = sw;
+}
+
+
+// evaluate programmable mixes, steering and throttle are sources
+//   for channels 1 and 2
+static void mix_evaluate(s16 steering, s16 throttle) {
+    mix_line_s *l = mix_line;
+    u8 i;
+    s16 val;
+#ifdef CALC_BENCH
+    u16 start = bench_tim2();
+#endif
+
+    memset(mix_value, 0, sizeof(mix_value));
+    for (i = mix_lines; i; i--, l++) {
+	// enable switch
+	if (l->sw) {
+	    if (l->sw & MIX_SW_LSW)
+		val = calc_switches & (u8)(1 << (l->sw & 0x0f)) ? 1 : -1;
+	    else val = last_value[(l->sw & 0x0f) - 1];
+	    if (l->sw & MIX_SW_REV)  val = -val;
+	    if (val <= 0)  continue;
+	}
+	// source value
+	if (l->src & MIX_SRC_IN)  val = ppm_in[l->src & 0x0f];
+	else if (l->src > 1)	  val = menu_channel3_8[l->src - 2] * PPM(5);
+	else if (l->src) val = throttle;
+	else		 val = steering;
+	val = (s16)(((s32)val * l->mul[val < 0 ? 0 : 1]) >> MIX_SHIFT)
+	      + l->offset;
+	// limit each line, sum of all lines cannot overflow
+	if (val < PPM(-500))       val = PPM(-500);
+	else if (val > PPM(500))   val = PPM(500);
+	mix_value[l->dst] += val;
+    }
+
+#ifdef CALC_BENCH
+    // timer counts from 0 to 1ms
+    start = bench_tim2() - start;
+    if ((s16)start < 0)  start += KHZ / 2;
+    calc_bench_last = start;
+    if (start > calc_bench_max)  calc_bench_max = start;
+#endif
+}
+
+
+// add mix to value and check limits
+static s16 mix_add(s16 val, u8 channel) {
+    val += mix_value[channel - 1];
+    if (val < PPM(-500))       val = PPM(-500);
+    else if (val > PPM(500))   val = PPM(500);
+    return val;
+}
+
+
 // apply steering speed
 static s16 steering_speed(s16 val, u8 channel) {
     s16 last = last_value[channel - 1];
     s16 delta = val - last;
     s16 delta2 = 0;
     s16 max_delta;
-    u8 stspd;
+    u8 stspd, rate = RATE_TURN;
 
     if (!delta)  return val;	// no change from previous val
     if (cm.stspd_turn == 100 && cm.stspd_return == 100)  return val; // max spd
@@ -160,10 +488,10 @@ static s16 steering_speed(s16 val, u8 channel) {
 	if (val < last)  stspd = cm.stspd_turn;	// more left turn
 	else {
 	    // right from previous
-	    if (val <= 0)  stspd = cm.stspd_return;  // return max to centre
-	    else {
+	    stspd = cm.stspd_return;
+	    rate = RATE_RETURN;
+	    if (val > 0) {
 		// right to right side of centre
-		stspd = cm.stspd_return;
 		delta = -last;
 		delta2 = val;
 	    }
@@ -174,10 +502,10 @@ static s16 steering_speed(s16 val, u8 channel) {
 	if (val > last)  stspd = cm.stspd_turn;	// more right turn
 	else {
 	    // left from previous
-	    if (val >= 0)  stspd = cm.stspd_return;  // return max to centre
-	    else {
+	    stspd = cm.stspd_return;
+	    rate = RATE_RETURN;
+	    if (val < 0) {
 		// left to left side of centre
-		stspd = cm.stspd_return;
 		delta = -last;
 		delta2 = val;
 	    }
@@ -186,7 +514,7 @@ static s16 steering_speed(s16 val, u8 channel) {
 
     // calculate max delta
     if (stspd == 100)  max_delta = PPM(1000);
-    else  max_delta = PPM(1000) / 2 / 20 * ppm_frame_length / (100 - stspd);
+    else  max_delta = speed_delta(rate, stspd);
 
     // compare delta with max_delta
     if (delta < 0) {
@@ -207,7 +535,7 @@ static s16 steering_speed(s16 val, u8 channel) {
     // check if it is moving from return to turn
     if (delta2) {
 	if (cm.stspd_turn == 100)  max_delta = PPM(1000);
-	else  max_delta = PPM(1000) / 2 / 20 * ppm_frame_length / (100 - cm.stspd_turn);
+	else  max_delta = speed_delta(RATE_TURN, cm.stspd_turn);
 
 	if (delta2 < 0) {
 	    if (max_delta < -delta2)  val = -max_delta;
@@ -221,6 +549,61 @@ static s16 steering_speed(s16 val, u8 channel) {
 }
 
 
+// throttle overlay values, prepared from model config
+@near static s16 thm_cut, thm_idle, thm_nbrake;
+void calc_throttle_prepare(void) {
+    thm_cut = (cm.thr_cut ? cm.thr_cut : 100) * PPM(5);
+    thm_idle = -(s16)(cm.idle_up * PPM(5));	// forward is minus
+    thm_nbrake = cm.neutral_brake * PPM(5);
+    if (cm.neutral_brake)  menu_throttle_mode |= THM_NBRAKE;
+    else  menu_throttle_mode &= (u8)~THM_NBRAKE;
+}
+
+// apply active throttle modes to calibrated throttle, called only when
+//   some of them is active
+// idle-up lifts only neutral and low forward, brake side is kept,
+//   it is applied before neutral brake, so it overrides it
+static s16 throttle_overlay(s16 val) {
+    u8 mode = menu_throttle_mode;
+    if (mode & THM_BRAKE)  return thm_cut;	// brake/cut overrides all
+    if ((mode & THM_HOLD) && val < 0)  val = 0;	// hold at neutral
+    if ((mode & THM_IDLE) && val <= 0 && val > thm_idle)  val = thm_idle;
+    if ((mode & THM_NBRAKE) && !val)  val = thm_nbrake;
+    return val;
+}
+
+
+// apply throttle acceleration to calibrated throttle, only when going
+//   from centre over trigger point, forward and brake side have own
+//   settings and own last values (at plus side), side not used is
+//   at centre
+@near static s16 accel_last[2];
+static s16 throttle_accel(s16 val) {
+    s16 trig, max_delta, last;
+    u8 fwd = (u8)(val < 0 ? 1 : 0);
+    u8 speed = fwd ? cm.accel_fwd : cm.accel_brk;
+
+    // compute at plus side
+    if (fwd)  val = -val;
+    accel_last[fwd ^ 1] = 0;
+
+    if (speed && speed < 100) {
+	last = accel_last[fwd];
+	trig = (fwd ? cm.accel_fwd_trig : cm.accel_brk_trig) * PPM(5);
+	if (last < trig)  last = trig;
+	if (val > last) {
+	    max_delta = speed_delta((u8)(fwd ? RATE_ACCEL_FWD : RATE_ACCEL_BRK),
+				    speed);
+	    if (val - last > max_delta)  val = last + max_delta;
+	}
+    }
+    accel_last[fwd] = val;
+
+    if (fwd)  val = -val;
+    return val;
+}
+
+
 // apply servo speed
 static s16 channel_speed(s16 val, u8 channel) {
     s16 last = last_value[channel - 1];
@@ -245,7 +628,7 @@ static s16 channel_speed(s16 val, u8 channel) {
 	}
     }
 
-    max_delta = PPM(1000) / 2 / 20 * ppm_frame_length / (100 - speed);
+    max_delta = speed_delta((u8)(channel - 1), speed);
     if (delta < 0) {
 	if (max_delta < -delta)  val = last - max_delta;
     }
@@ -266,11 +649,27 @@ static s16 channel_speed(s16 val, u8 channel) {
 static void calc_loop(void) {
     s16 val, val2;
     u8  i, bit;
-    s16 DIG_mix;
+    s16 DIG_mix, throttle;
     u16 adc_steering, adc_throttle;  // last 4 or 1 ADC values
 
     while (1) {
 
+	// time from previous cycle, speeds are applied to it
+	val = time_ms - calc_time_ms;
+	calc_time_ms += val;
+	calc_elapsed = (u8)((u16)val > RATE_MAX_MS ? RATE_MAX_MS : val);
+
+	// decode PPM input captured from previous cycle
+	ppm_in_update();
+	ppm_in_active = (u8)(ppm_in_channels ? ppm_in_outputs : 0);
+
+	// model is being changed, repeat last values till it is applied
+	if (calc_hold) {
+	    ppm_hold_frame();
+	    stop();
+	    continue;
+	}
+
 	// handle channel3 potentiometer, cannot use channel_calib,
 	//   because we don't have calib middle and dead zone
 	if (cg.ch3_pot && !menu_ch3_pot_disabled) {
@@ -313,8 +712,34 @@ static void calc_loop(void) {
 			    cg.calib_steering_mid << ADC_OVS_SHIFT,
 			    cg.calib_steering_right << ADC_OVS_SHIFT,
 			    cg.steering_dead_zone << ADC_OVS_SHIFT);
-	val = expo(val, cm.expo_steering);
+	if (cm.curve_steering)  val = curve(0, cm.curve_steering, val);
+	else  val = expo(val, cm.expo_steering);
 	val = dualrate(val, cm.dr_steering);
+
+	// throttle
+	val2 = channel_calib(adc_throttle,
+			     cg.calib_throttle_fwd << ADC_OVS_SHIFT,
+			     cg.calib_throttle_mid << ADC_OVS_SHIFT,
+			     cg.calib_throttle_bck << ADC_OVS_SHIFT,
+			     cg.throttle_dead_zone << ADC_OVS_SHIFT);
+	val2 = throttle_accel(val2);
+	if (menu_throttle_mode)  val2 = throttle_overlay(val2);
+	if (cm.curve_throttle)  val2 = curve(1, cm.curve_throttle, val2);
+	else  val2 = expo(val2, (u8)(val2 < 0 ? cm.expo_forward : cm.expo_back));
+	if (cm.abs_type) {
+	    // ABS pulses are generated at 1ms timer, only apply them
+	    calc_abs_brake = (u8)(val2 > abs_trigger ? 1 : 0);
+	    if (abs_reduce)  val2 = (s16)(((s32)val2 * abs_mul) >> 8);
+	}
+	val2 = dualrate(val2, (u8)(val2 < 0 ? cm.dr_forward : cm.dr_back));
+
+	// logical switches and programmable mixes
+	switches_evaluate(val, val2);
+	mix_evaluate(val, val2);
+	val = mix_add(val, 1);
+	throttle = mix_add(val2, 2);
+
+	// steering output
 	if (cm.channel_DIG != 1) {
 	    // channel 1 is normal servo steering
 	    if (!cm.channel_4WS)
@@ -368,40 +793,7 @@ static void calc_loop(void) {
 
 
 	// throttle
-	if (menu_brake)
-	    val = PPM(500);	// brake button overrides throttle
-	else
-	    val = channel_calib(adc_throttle,
-				cg.calib_throttle_fwd << ADC_OVS_SHIFT,
-				cg.calib_throttle_mid << ADC_OVS_SHIFT,
-				cg.calib_throttle_bck << ADC_OVS_SHIFT,
-				cg.throttle_dead_zone << ADC_OVS_SHIFT);
-	val = expo(val, (u8)(val < 0 ? cm.expo_forward : cm.expo_back));
-	if (cm.abs_type) {
-	    // apply selected ABS
-	    static u8    abs_time;
-	    static _Bool abs_state;	// when 1, lower brake value
-	    // cycle time in 1ms steps: 120/80/60ms
-	    u8 cycle_time = (u8)(cm.abs_type == 1 ? 120 :
-				 cm.abs_type == 2 ? 80 : 60);
-
-	    if (val > ABS_THRESHOLD) {
-		// check time with 40ms reserve and change abs_state
-		if ((u8)(ppm_timer - abs_time) <= 40) {
-		    abs_time = (u8)(ppm_timer + cycle_time);
-		    abs_state ^= 1;
-		}
-		// apply ABS
-		if (abs_state)
-		    val /= 2;
-	    }
-	    else {
-		// no ABS
-		abs_time = (u8)(ppm_timer + cycle_time);
-		abs_state = 0;
-	    }
-	}
-	val = dualrate(val, (u8)(val < 0 ? cm.dr_forward : cm.dr_back));
+	val = throttle;
 	// brake to extra channel
 	if (cm.channel_brake) {
 	    val2 = val;
@@ -438,11 +830,14 @@ static void calc_loop(void) {
 
 
 
-	// channels 3-8, exclude mixed channels in the future
+	// channels 3-8, exclude mixed channels
 	for (i = 3, bit = 0b100; i <= channels; i++, bit <<= 1) {
-	    // check if channel was already mixed before (4WS, DIG)
+	    // check if channel was already mixed before (4WS, DIG, brake)
 	    if (menu_channels_mixed & bit)  continue;
-	    channel_params(i, channel_speed(menu_channel3_8[i - 3] * PPM(5), i));
+	    val = menu_channel3_8[i - 3] * PPM(5);
+	    // add programmable mixes to channel value
+	    if (mix_channels & bit)  val = mix_add(val, i);
+	    channel_params(i, channel_speed(val, i));
 	}
 
 
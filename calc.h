@@ -28,5 +28,31 @@
 E_TASK(CALC);
 
 
+// prepare programmable mixes, return channels driven by them
+extern void calc_mix_prepare(u8 mixed);
+// logical switches, one bit for each
+extern u8 calc_switches;
+// hold PPM values during model change
+extern _Bool calc_hold;
+// prepare steering and throttle curves
+extern void calc_curve_prepare(void);
+
+// PPM input to output channels mapping
+extern void calc_ppm_in_prepare(void);
+
+// ABS
+extern volatile u8 calc_abs_brake;	// brake over ABS trigger point
+extern void calc_abs_prepare(void);
+extern void calc_abs_tick(void);	// called every 1ms
+
+// throttle overlay (brake/cut, hold, idle-up, neutral brake)
+extern void calc_throttle_prepare(void);
+
+#ifdef CALC_BENCH
+// TIM2 ticks (2 CPU cycles) of programmable mixes evaluation
+extern u16 calc_bench_last, calc_bench_max;
+#endif
+
+
 #endif
 
@@ -19,6 +19,7 @@
 
 
 #include <string.h>
+#include <stddef.h>
 #include "config.h"
 #include "eeprom.h"
 #include "input.h"
@@ -61,16 +62,14 @@ u8 config_global_set_default(void) {
     cg.poweron_beep	= 1;
     cg.poweron_warn	= 0;
 
-    cg.timer1_type	= 0;		// OFF
-    cg.timer2_type	= 0;
-    cg.timer1_alarm	= 0;		// OFF
-    cg.timer2_alarm	= 0;
+    memset(cg.timer, 0, sizeof(cg.timer));	// OFF, alarm OFF
 
     cg.ppm_sync_frame	= 0;		// to constant SYNC length
     cg.ppm_length	= 1;		// 4ms constant SYNC length
     cg.rotate_reverse	= 0;		// not-reversed
     cg.ch3_pot		= 0;		// CH3 is button
     cg.encoder_2detents	= 0;		// use 2 detents to change value
+    cg.ppm_in		= 0;		// no PPM input
 
     // set calibrate values only when they are out of limits
     cc |= check_val(&cg.calib_steering_left, 0, CALIB_ST_LOW_MID, 0);
@@ -91,21 +90,73 @@ u8 config_global_set_default(void) {
 
 
 
-// default model key mapping
-static const config_key_mapping_s default_key_mapping = {
-    // keys: function, function_long
+// MAX_CHANNELS times given value
+#define CHV3(v)		v, v, v
+#define CHV4(v)		CHV3(v), v
+#define CHV5(v)		CHV4(v), v
+#define CHV6(v)		CHV5(v), v
+#define CHV7(v)		CHV6(v), v
+#define CHV8(v)		CHV7(v), v
+#define CHV_(n, v)	CHV ## n(v)
+#define CHV(n, v)	CHV_(n, v)
+
+// model configuration defaults not depending on global config, it is
+//   used also as base for packed models, name and model number are set
+//   by model_set_base()
+// it is in FLASH, so packing can compare with it without touching
+//   actual model config used by CALC
+static const config_model_s model_base = {
+    { 0, 0, 0 },			// name
+    0,					// reverse
+    { 0 },				// subtrim
+    { CHV(MAX_CHANNELS, 100), CHV(MAX_CHANNELS, 100) },	// endpoint
+    { CHV(MAX_CHANNELS, 100) },		// speed
+    100,				// stspd_return
+    { 0, 0 },				// trim
+    { 100, 100, 100 },			// dualrate
+    { 0, 0, 0 },			// expo
+    { -100, MULTI_POSITION_END, MULTI_POSITION_END, MULTI_POSITION_END,
+      MULTI_POSITION_END, MULTI_POSITION_END, MULTI_POSITION_END,
+      MULTI_POSITION_END },
+    { -100, MULTI_POSITION_END, MULTI_POSITION_END, MULTI_POSITION_END,
+      MULTI_POSITION_END, MULTI_POSITION_END },
+    { -100, MULTI_POSITION_END, MULTI_POSITION_END, MULTI_POSITION_END },
+    { -100, MULTI_POSITION_END, MULTI_POSITION_END, MULTI_POSITION_END },
+    2,					// channels
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// brake_off .. channel_brake
+    CURVE_EXP, CURVE_EXP,		// curve_steering, curve_throttle
+    0,					// unused3
+
+    // key mapping
     {
-	{ 0, 0, 0, 0, 0, 0, 0, 0 },	// CH3 to nothing
-	{ 0, 0, 0, 0, 0, 0, 0, 0 },	// BACK to nothing
-	{ 0, 0, 0, 0, 1, 0, 0, 0 }	// END-long to battery low shutup
+	// keys: function, function_long
+	{
+	    { 0, 0, 0, 0, 0, 0, 0, 0 },	// CH3 to nothing
+	    { 0, 0, 0, 0, 0, 0, 0, 0 },	// BACK to nothing
+	    { 0, 0, 0, 0, 1, 0, 0, 0 }	// END-long to battery low shutup
+	},
+	// trims: function, reverse, step, buttons
+	{
+	    { 1, 1, 0, 0, 0, 0, ETB_LONG_OFF, 0, 0, 1, 0 },	// trim1 to steer trim
+	    { 2, 1, 0, 0, 0, 0, ETB_LONG_OFF, 0, 0, 1, 0 },	// trim2 to throt trim
+	    { 1, 1, 0, 0, 0, 0, ETB_LONG_OFF, 0, 0, 1, 0 },	// trim3 to steer trim
+	    { 3, 1, 0, 0, 0, 0, ETB_AUTORPT, 0, 0, 1, 0 }	// trim4(DR) to steer dualrate, autorepeat
+	},
     },
-    // trims: function, reverse, step, buttons
-    {
-	{ 1, 1, 0, 0, 0, 0, ETB_LONG_OFF, 0, 0, 1, 0 },	// trim1 to steer trim
-	{ 2, 1, 0, 0, 0, 0, ETB_LONG_OFF, 0, 0, 1, 0 },	// trim2 to throt trim
-	{ 1, 1, 0, 0, 0, 0, ETB_LONG_OFF, 0, 0, 1, 0 },	// trim3 to steer trim
-	{ 3, 1, 0, 0, 0, 0, ETB_AUTORPT, 0, 0, 1, 0 }	// trim4(DR) to steer dualrate, autorepeat
+
+    { { 0 } },				// mix
+    {					// curves linear
+	{ { -100, -75, -50, -25, 0, 25, 50, 75, 100 }, 50, 50 },
+	{ { -100, -75, -50, -25, 0, 25, 50, 75, 100 }, 50, 50 }
     },
+    { { 0 } },				// lsw
+    0, 0, 0, 0, 0,			// ABS
+    0, 0, 0, 0,				// acceleration
+    0, 0, 0,				// throttle overlay
+    0,					// model
+    { 0 },				// ppm_in_map
+    { 0 },				// ppm_out_map
+    0					// crc
 };
 
 // set default name to given pointer
@@ -116,138 +167,488 @@ static void default_model_name(u8 model, u8 *name) {
 }
 
 
+// set model configuration to defaults not depending on global config,
+//   it is used also as base for packed models
+static void model_set_base(u8 model) {
+    memcpy(&cm, &model_base, sizeof(config_model_s));
+    default_model_name(model, cm.name);
+    cm.model = model;
+}
+
 // set model configuration to default
 void config_model_set_default(void) {
-    default_model_name(cg.model, cm.name);
+    model_set_base(cg.model);
     cm.channels		= cg.channels_default;
-
-    cm.reverse		= 0;
-    memset(cm.subtrim, 0, sizeof(cm.subtrim));
-    memset(cm.endpoint, 100, sizeof(cm.endpoint));
-    cm.trim_steering	= 0;
-    cm.trim_throttle	= 0;
-
-    cm.dr_steering	= 100;
-    cm.dr_forward	= 100;
-    cm.dr_back		= 100;
-
-    cm.expo_steering	= 0;
-    cm.expo_forward	= 0;
-    cm.expo_back	= 0;
-
-    memset(cm.speed, 100, sizeof(cm.speed));
-    cm.stspd_return	= 100;
-
-    cm.abs_type		= 0;
-    cm.brake_off	= 0;
-    cm.thspd_onlyfwd	= 0;
-
-    cm.channel_4WS	= 0;
-    cm.channel_DIG	= 0;
-    cm.channel_brake	= 0;
-
-    cm.channel_MP0	= 0;
-    memset(cm.multi_position0, (u8)MULTI_POSITION_END, sizeof(cm.multi_position0));
-    cm.multi_position0[0]= -100;
-    cm.channel_MP1	= 0;
-    memset(cm.multi_position1, (u8)MULTI_POSITION_END, sizeof(cm.multi_position1));
-    cm.multi_position1[0]= -100;
-    cm.channel_MP2	= 0;
-    memset(cm.multi_position2, (u8)MULTI_POSITION_END, sizeof(cm.multi_position2));
-    cm.multi_position2[0]= -100;
-    cm.channel_MP3	= 0;
-    memset(cm.multi_position3, (u8)MULTI_POSITION_END, sizeof(cm.multi_position3));
-    cm.multi_position3[0]= -100;
-
-    memcpy(&cm.key_mapping, &default_key_mapping, sizeof(config_key_mapping_s));
     if (cg.ch3_pot) {
 	*ck_ch3_pot_func = 0;
 	*ck_ch3_pot_rev  = 0;
     }
+}
+
+
+
+
+
+
+// journal of often changed values
+//   changed trims and subtrims of actual model and selected model number
+//   are appended to journal instead of rewriting model/global config,
+//   so writes are spread over all journal EEPROM cells
+//   journal is a ring buffer, entries have sequence numbers,
+//   SYNC entry marks, that all previous entries are at model/global config,
+//   MODEL entry selects model and drops previous trim entries
+#define JRN_ENTRIES	(u8)(EEPROM_JOURNAL_SIZE / sizeof(journal_entry_s))
+#define JRN_MODEL	0xfe
+#define JRN_SYNC	0xff
+#define JRN_HOT		(MAX_CHANNELS + 2)
+#define JRN_SUBTRIM	((u8)offsetof(config_model_s, subtrim))
+#define JRN_TRIM	((u8)offsetof(config_model_s, trim))
+
+static u8 jrn_pos;		// position of next entry
+static u8 jrn_seq;		// sequence number of next entry
+static u8 jrn_live;		// number of entries after last SYNC
+@near static u8 jrn_hot[JRN_HOT];	// saved values of subtrims and trims
+
+#define jrn_entry(idx)	((journal_entry_s *)EEPROM_JOURNAL + (idx))
+#define jrn_check(e)	(u8)~(u8)((e)->seq + (e)->id + (e)->val)
+#define jrn_next(idx)	(u8)((idx) < JRN_ENTRIES - 1 ? (idx) + 1 : 0)
+#define jrn_prev(idx)	(u8)((idx) ? (idx) - 1 : JRN_ENTRIES - 1)
+
+
+static u8 jrn_valid(u8 idx) {
+    journal_entry_s *e = jrn_entry(idx);
+    return (u8)(e->check == jrn_check(e));
+}
+
+// position of first entry after last SYNC
+static u8 jrn_first(void) {
+    if (jrn_pos >= jrn_live)  return (u8)(jrn_pos - jrn_live);
+    return (u8)(jrn_pos + JRN_ENTRIES - jrn_live);
+}
+
+// model config offset of hot value
+static u8 jrn_hot_id(u8 i) {
+    if (i < MAX_CHANNELS)  return (u8)(JRN_SUBTRIM + i);
+    return (u8)(JRN_TRIM - MAX_CHANNELS + i);
+}
+
+// remember saved hot values
+static void journal_hot_set(void) {
+    memcpy(jrn_hot, cm.subtrim, MAX_CHANNELS);
+    memcpy(jrn_hot + MAX_CHANNELS, cm.trim, 2);
+}
+
+
+static void journal_append(u8 id, u8 val) {
+    journal_entry_s e;
+
+    e.seq = jrn_seq++;
+    e.id = id;
+    e.val = val;
+    e.check = jrn_check(&e);
+    eeprom_write_journal(jrn_pos, &e);
+    jrn_pos = jrn_next(jrn_pos);
+    if (id == JRN_SYNC)  jrn_live = 0;
+    else		 jrn_live++;
+}
+
+// append MODEL entry, when journal is full, write global config and SYNC,
+//   model config must be already written
+static void journal_model_entry(void) {
+    if (jrn_live < JRN_ENTRIES - 1) {
+	journal_append(JRN_MODEL, cg.model);
+	return;
+    }
+    eeprom_write_global();
+    journal_append(JRN_SYNC, 0);
+}
+
+
+// find last entry and last SYNC, set selected model
+static void journal_init(void) {
+    u8 i, idx;
+    journal_entry_s *e;
+
+    // find newest entry, next entry is not following it
+    for (i = 0; i < JRN_ENTRIES; i++) {
+	if (!jrn_valid(i))  continue;
+	idx = jrn_next(i);
+	if (jrn_valid(idx) &&
+	    jrn_entry(idx)->seq == (u8)(jrn_entry(i)->seq + 1))  continue;
+	break;
+    }
+    if (i == JRN_ENTRIES)  return;	// empty journal
+    jrn_pos = jrn_next(i);
+    jrn_seq = (u8)(jrn_entry(i)->seq + 1);
+
+    // count entries after last SYNC
+    e = jrn_entry(i);
+    while (e->id != JRN_SYNC) {
+	if (++jrn_live == JRN_ENTRIES)  break;
+	idx = jrn_prev(i);
+	if (!jrn_valid(idx) || jrn_entry(idx)->seq != (u8)(e->seq - 1))  break;
+	i = idx;
+	e = jrn_entry(i);
+    }
+
+    // set last selected model
+    idx = jrn_first();
+    for (i = jrn_live; i; i--) {
+	e = jrn_entry(idx);
+	if (e->id == JRN_MODEL && e->val < CONFIG_MODEL_MAX)  cg.model = e->val;
+	idx = jrn_next(idx);
+    }
+}
+
+
+// set hot values of actual model (after last MODEL entry)
+static void journal_model(void) {
+    u8 i, idx, first, cnt;
+    journal_entry_s *e;
+
+    // find last MODEL entry
+    idx = first = jrn_first();
+    cnt = jrn_live;
+    for (i = jrn_live; i; i--) {
+	e = jrn_entry(idx);
+	idx = jrn_next(idx);
+	if (e->id != JRN_MODEL)  continue;
+	first = idx;
+	cnt = (u8)(i - 1);
+    }
+
+    // and apply values
+    for (; cnt; cnt--) {
+	e = jrn_entry(first);
+	if (e->id < sizeof(config_model_s))  ((u8 *)&cm)[e->id] = e->val;
+	first = jrn_next(first);
+    }
+    journal_hot_set();
+}
+
+
+// save changed hot values to journal, return 0 when other values
+//   changed or when there is no space at journal
+static u8 journal_model_save(u8 *rec) {
+    u8 *ram = (u8 *)&cm;
+    u8 i, id, cnt = 0;
+
+    // compare with saved values
+    for (i = 0; i < JRN_HOT; i++)
+	if (ram[jrn_hot_id(i)] != jrn_hot[i])  cnt++;
+    for (i = 0; i < sizeof(config_model_s); i++) {
+	if ((u8)(i - JRN_SUBTRIM) < MAX_CHANNELS ||
+	    (u8)(i - JRN_TRIM) < 2)  continue;
+	if (ram[i] != rec[i])  return 0;
+    }
+    if (jrn_live + cnt >= JRN_ENTRIES)  return 0;
+
+    // append changed values
+    for (i = 0; i < JRN_HOT; i++) {
+	id = jrn_hot_id(i);
+	if (ram[id] == jrn_hot[i])  continue;
+	journal_append(id, ram[id]);
+	jrn_hot[i] = ram[id];
+    }
+    return 1;
+}
+
+
+
+
+
+
+// index of packed models with encoded names (0 = empty memory), so model
+//   menu doesn't need to search packed models
+// name has 3 chars 0-9A-Z, it is encoded as number + 1
+@near static u16 model_index[CONFIG_MODEL_MAX];
+// bitmap of used model memories, empty ones are skipped by whole bytes
+@near static u8 model_used[(CONFIG_MODEL_MAX + 7) / 8];
+#define model_used_set(m)  (model_used[(m) >> 3] |= (u8)(1 << ((m) & 7)))
+
+static u16 name_encode(u8 *name) {
+    u16 code = 0;
+    u8 i, c;
+
+    for (i = 0; i < 3; i++) {
+	c = name[i];
+	if (c >= 'A' && c <= 'Z')  c -= 'A' - 10;
+	else if (c >= '0' && c <= '9')  c -= '0';
+	else  c = 0;
+	code = code * 36 + c;
+    }
+    return code + 1;
+}
 
-    cm.unused		= 0;
-    cm.unused2		= 0;
-    cm.unused3		= 0;
-    memset(cm.reserve, 0, sizeof(cm.reserve));
+static void name_decode(u16 code, u8 *name) {
+    u8 i, c;
+
+    code--;
+    for (i = 3; i; ) {
+	c = (u8)(code % 36);
+	code /= 36;
+	name[--i] = (u8)(c < 10 ? c + '0' : c - 10 + 'A');
+    }
 }
 
+// set name from packed model
+static void pack_name(u8 model, u8 *bitmap, u8 *name) {
+    u8 *data = bitmap + PACK_BITMAP;
+    u8 i;
 
+    default_model_name(model, name);
+    for (i = 0; i < 3; i++)
+	if (*bitmap & (u8)(1 << i))  name[i] = *data++;
+}
+
+static void index_add(u8 model, u8 *rec) {
+    u8 name[3];
+
+    if (model >= CONFIG_MODEL_MAX)  return;
+    if (model_index[model]) {
+	// more copies after power loss while packing or moving it,
+	//   keep only last one
+	rec = eeprom_pack_find(model);
+	eeprom_pack_delete(model, rec);
+    }
+    pack_name(model, rec, name);
+    model_index[model] = name_encode(name);
+    model_used_set(model);
+}
+
+// build index of packed models
+static void model_index_build(void) {
+    memset(model_index, 0, sizeof(model_index));
+    memset(model_used, 0, sizeof(model_used));
+    eeprom_pack_walk(index_add);
+}
+
+
+// return next/previous used model memory (or actual model), bytes
+//   of bitmap without used models are skipped, so at most all bytes
+//   of bitmap and bits of one byte are tested
+u8 config_model_next(u8 model, u8 down) {
+    u8 idx = (u8)(model >> 3);
+    u8 n = sizeof(model_used) + 1;	// own byte is tested once more
+    u8 bits;
+
+    // actual model will be stored at model change, so it is used
+    model_used_set(cg.model);
+
+    // models after/before given one in its byte
+    bits = model_used[idx];
+    if (down)  bits &= (u8)((1 << (model & 7)) - 1);
+    else       bits &= (u8)(0xfe << (model & 7));
+
+    // skip empty bytes
+    while (!bits) {
+	if (!--n)  return model;
+	if (down)  idx = (u8)(idx ? idx - 1 : sizeof(model_used) - 1);
+	else	   idx = (u8)(idx < sizeof(model_used) - 1 ? idx + 1 : 0);
+	bits = model_used[idx];
+    }
+
+    // nearest used model in this byte
+    model = (u8)(idx << 3);
+    if (down) {
+	model += 7;
+	for (; !(bits & 0x80); bits <<= 1)  model--;
+    }
+    else  for (; !(bits & 1); bits >>= 1)  model++;
+    return model;
+}
+
+
+
+
+// packed models, only bytes different from model_set_base() are stored,
+//   see eeprom.h
+
+// byte of base values for actual model number, name is its default name
+static u8 pack_base(u8 *name, u8 i) {
+    if (i < sizeof(cm.name))  return name[i];
+    if (i == (u8)offsetof(config_model_s, model))  return cg.model;
+    return ((u8 *)&model_base)[i];
+}
+#define pack_diff(i)  (ee[i] != pack_base(name, i))
+
+// pack actual model (it must be already saved to EEPROM) to its memory,
+//   return 0 when there is no space
+// it is compared with model_base in FLASH, actual model config is not
+//   changed, because other tasks run while EEPROM/FLASH is written
+static u8 model_pack(void) {
+    u8 *ee = EEPROM_CONFIG_MODEL;
+    u8 *rec;
+    u8 i, j, k, cnt = 0, len, val, mask;
+    u8 word[4];
+    u8 name[3];
+
+    // compare with base values
+    default_model_name(cg.model, name);
+    for (i = 0; i < sizeof(config_model_s); i++)
+	if (pack_diff(i))  cnt++;
+    len = PACK_LEN(cnt);
+
+    // previous version is deleted only after new one is written,
+    //   it is last known-good copy
+    rec = eeprom_pack_alloc(len);
+    if (!rec)  return 0;
+
+    // write bitmap, different bytes, padding and trailer,
+    //   word with trailer is written as last
+    j = k = 0;
+    for (i = 0; i < len; i++) {
+	if (i >= len - PACK_TRAILER)
+	    val = (u8)(i == len - 1 ? len : cg.model + 1);
+	else if (i < PACK_BITMAP) {
+	    val = 0;
+	    for (mask = 1; mask; mask <<= 1, j++)
+		if (j < sizeof(config_model_s) && pack_diff(j))  val |= mask;
+	}
+	else if (cnt) {
+	    while (!pack_diff(k))  k++;
+	    val = ee[k++];
+	    cnt--;
+	}
+	else  val = 0;
+	word[i & 3] = val;
+	if ((i & 3) == 3 && i != len - 1)  eeprom_write_word(rec + i - 3, word);
+    }
+    eeprom_write_word(rec + len - 4, word);
+
+    // delete previous version
+    eeprom_pack_delete(cg.model, rec);
+    model_index[cg.model] = name_encode(cm.name);
+    model_used_set(cg.model);
+    return 1;
+}
+
+
+// unpack model from its memory, return 0 when it is empty or corrupted
+static u8 model_unpack(u8 model) {
+    u8 *bitmap = eeprom_pack_find(model);
+    u8 *data;
+    u8 *dst = (u8 *)&cm;
+    u8 i, mask = 1;
+
+    if (!bitmap)  return 0;
+    model_set_base(model);
+    data = bitmap + PACK_BITMAP;
+    for (i = 0; i < sizeof(config_model_s); i++) {
+	if (*bitmap & mask)  dst[i] = *data++;
+	if (!(mask <<= 1)) {
+	    mask = 1;
+	    bitmap++;
+	}
+    }
+    return eeprom_check(&cm, sizeof(config_model_s));
+}
 
 
 
 
 // read model config from eeprom/flash, if empty, set to defaults
-// first read after poweron should read FLASH model from
-//   eeprom CONFIG_MODEL_TMP, because FLASH memory is updated
-//   only after model change (so when powered off, current memory
-//   is only at tmp eeprom and not in FLASH)
+// actual model is always at EEPROM_CONFIG_MODEL, its packed memory
+//   is updated only after model change (so it is last known-good copy
+//   of actual model)
+// first read after poweron reads actual model, when it is corrupted
+//   or it is other model (model change was interrupted), packed
+//   memory is used
+// new model is selected at journal only after it is written to actual
+//   model place
 void config_model_read(void) {
     static _Bool not_first;
-    u8 model = cg.model;
-
-    if (!not_first && cg.model > CONFIG_MODEL_TMP)
-	model = CONFIG_MODEL_TMP;
 
-    if (model < CONFIG_MODEL_TMP || !not_first) {
-	// it is in eeprom
+    if (!not_first) {
 	not_first = 1;
-	eeprom_read_model(model);
-	// if it was empty place, set it to defaults
-	if (config_model.name[0] != CONFIG_MODEL_EMPTY)  return;
-	config_model_set_default();
+	eeprom_read_model();
+	if (config_model.name[0] != CONFIG_MODEL_EMPTY &&
+	    config_model.model == cg.model &&
+	    eeprom_check(&config_model, sizeof(config_model_s))) {
+	    journal_model();
+	    return;
+	}
+	// unpack model and apply its journaled values
+	if (!model_unpack(cg.model))  config_model_set_default();
+	journal_model();
+	eeprom_write_model();
+	journal_hot_set();
 	return;
     }
-    // it is in flash, read it and save to tmp eeprom
-    flash_read_model((u8)(cg.model - CONFIG_MODEL_TMP));
-    // if not configured, set to defaults before saving
-    //   to tmp eeprom
-    if (config_model.name[0] == CONFIG_MODEL_EMPTY)
-	config_model_set_default();
-    // save it to tmp eeprom
-    eeprom_write_model(CONFIG_MODEL_TMP);
+
+    // unpack new model, if not configured or corrupted, set to defaults
+    if (!model_unpack(cg.model))  config_model_set_default();
+    // save it to actual model place and then select it,
+    //   MODEL entry drops journaled values of previous model
+    eeprom_write_model();
+    journal_hot_set();
+    journal_model_entry();
 }
 
 
 // return model name for given model number
 u8 *config_model_name(u8 model) {
     @near static u8 fake_name[3];
-    u8 *addr;
 
     if (model == cg.model)  return cm.name;	// actual model
 
-    if (model < CONFIG_MODEL_TMP)
-	// eeprom
-	addr = EEPROM_CONFIG_MODEL + sizeof(config_model_s) * model;
-    else
-	// flash
-	addr = (u8 *)(0 - sizeof(config_model_s) * (model - CONFIG_MODEL_TMP + 1));
-
-    // if not configured, return default name
-    if (*addr == CONFIG_MODEL_EMPTY) {
-	default_model_name(model, fake_name);
-	addr = fake_name;
-    }
-    return addr;
+    if (model_index[model])  name_decode(model_index[model], fake_name);
+    else  default_model_name(model, fake_name);
+    return fake_name;
 }
 
 
 
 
-// save model config to eeprom (to temporary location if model is in FLASH)
+// save model config to eeprom actual model place
+// when only trims changed, append them to journal
+static void model_write(void) {
+    eeprom_write_model();
+    journal_hot_set();
+}
+
 void config_model_save(void) {
-    u8 model = cg.model;
-    if (model > CONFIG_MODEL_TMP)  model = CONFIG_MODEL_TMP;  // temporary place
-    eeprom_write_model(model);
+    if (journal_model_save(EEPROM_CONFIG_MODEL))  return;
+    model_write();
+    // drop journaled trims of this model
+    if (jrn_live)  journal_model_entry();
 }
 
 
-// set new global model, if previous model was from flash, save it
-//   there firstly
-void config_set_model(u8 model) {
-    if (cg.model >= CONFIG_MODEL_TMP)
-	flash_write_model((u8)(cg.model - CONFIG_MODEL_TMP));
+// set new global model, previous model is packed to its memory firstly
+// new model is read by config_model_read(), at saveas actual values
+//   are saved to it
+// return 0 when there is no space for it
+u8 config_set_model(u8 model, u8 saveas) {
+    model_write();
+    if (!model_pack())  return 0;
     cg.model = model;
-    config_global_save();
+    if (!saveas)  return 1;
+    cm.model = model;
+    model_write();
+    journal_model_entry();
+    return 1;
+}
+
+
+// save global config, actual model with journaled values is also saved
+//   to be able to drop journal
+void config_global_save(void) {
+    eeprom_write_global();
+    if (!jrn_live)  return;
+    model_write();
+    journal_append(JRN_SYNC, 0);
+}
+
+
+// empty all models and journal
+void config_empty_models(void) {
+    eeprom_empty_models();
+    memset(model_index, 0, sizeof(model_index));
+    memset(model_used, 0, sizeof(model_used));
+    eeprom_empty_journal();
+    jrn_pos = 0;
+    jrn_live = 0;
 }
 
 
@@ -258,10 +659,15 @@ void config_set_model(u8 model) {
 u8 config_global_read(void) {
     u8 calib_changed = 0;
 
-    eeprom_read_global();
+    if (!eeprom_read_global() && cg.magic_global == CONFIG_GLOBAL_MAGIC) {
+	// global config and its shadow corrupted, set defaults, keep models
+	calib_changed = config_global_set_default();
+	config_global_save();
+    }
     if (cg.magic_global != CONFIG_GLOBAL_MAGIC) {
 	// global config changed, initialize whole eeprom
-	eeprom_empty_models();
+	config_empty_models();
+	eeprom_empty_laplog();
 	calib_changed = config_global_set_default();
 	// do not write magic_global yet to eliminate interrupted initialization
 	//   (for example flash-verify after flash-write in STVP)
@@ -273,7 +679,7 @@ u8 config_global_read(void) {
     }
     else if (cg.magic_model != CONFIG_MODEL_MAGIC) {
 	// model config changed, empty all models
-	eeprom_empty_models();
+	config_empty_models();
 	// set model number to 0
 	cg.model = 0;
 	config_global_save();
@@ -281,6 +687,8 @@ u8 config_global_read(void) {
 	cg.magic_model = CONFIG_MODEL_MAGIC;
 	config_global_save();
     }
+    else  journal_init();
+    model_index_build();
 
     return calib_changed;
 }
@@ -28,11 +28,20 @@
 
 // global config
 
+// timers, type and alarm of each timer are at global config
+#define TIMER_NUM	2
+typedef struct {
+    u8	type:3;			// type of timer
+    u8	sw:3;			// running while logical switch 1..4 is on, 0 off
+    u8	unused:2;
+    u8	alarm;			// alarm of timer
+} config_timer_s;
+
 // change MAGIC number when changing global config
 // also add code to setting default values at config.c
 // length must by multiple of 4 because of EEPROM Word programming
-// 52 bytes (16 reserved)
-#define CONFIG_GLOBAL_MAGIC  0xf807
+// 52 bytes (12 reserved, 2 bytes less for each next timer), crc must be last
+#define CONFIG_GLOBAL_MAGIC  0xf80c
 typedef struct {
     u8  steering_dead_zone;
     u8  throttle_dead_zone;
@@ -52,26 +61,25 @@ typedef struct {
     u8  battery_low;		// low battery threshold in .1 Volts
     u8  endpoint_max;		// max allowed endpoint value (def 120%)
     u8  long_press_delay;	// long press delay in 5ms steps
-    u8	timer1_alarm;		// alarm of timer
-    u8	timer2_alarm;
+    config_timer_s timer[TIMER_NUM];	// type and alarm of timers
 
     u8  inactivity_alarm:4;	// time (min) of inactivity warning
     u8	key_beep:1;		// beep on key press
     u8	reset_beep:1;		// beep on center/reset value
     u8	poweron_beep:1;		// beep on power on
     u8	adc_ovs_last:1;		// use oversampled (0) or last (1) value in CALC
-    u8  timer1_type:3;		// type of timer
-    u8	timer2_type:3;
     u8	poweron_warn:1;		// beep 3 times when not-centered poweron
     u8	rotate_reverse:1;	// reverse rotate encoder sense
     u8	ppm_length:4;		// length of PPM sync signal (3..) or frame length (9..)
     u8	ppm_sync_frame:1;	// 0 = constant SYNC length, 1 = constant frame length
-    u8	channels_default:3;	// default number of channels for model
     u8  ch3_pot:1;		// potentiometer connected instead of CH3 button
+    u8	channels_default:3;	// default number of channels for model
     u8	encoder_2detents:1;	// use 2 encoder detents to change value (weak GT3C encoder)
+    u8	ppm_in:1;		// capture PPM input signal at PD7
 
-    u8  unused:6;		// reserve
-    u8	reserve[16];
+    u8  unused:3;		// reserve
+    u8	reserve[14 - 2 * (TIMER_NUM - 1)];
+    u16	crc;			// computed at eeprom write
 } config_global_s;
 
 extern config_global_s config_global;
@@ -136,14 +144,63 @@ typedef struct {
 #define MULTI_POSITION_END   -128
 #define MP_DIG               0x0f
 
+// programmable mix line, destination gets source multiplied by rate
+//   of source side plus offset, when enable switch is on
+#define MIX_LINES	     4
+typedef struct {
+    u8	src:4;			// source channel 1..8 (1,2 steering/throttle),
+				//   over MAX_CHANNELS PPM input 1..4
+    u8	dst:4;			// destination channel 1..8 or 0 when off
+    s8	sw;			// 0 always, +-channel enabled at its +- side
+    s8	rate[2];		// -100..100 for negative/positive source side
+    s8	offset;			// -100..100
+} config_mix_s;
+
+// curves for steering and throttle used instead of expo
+//   CRV has 9 points at -100,-75,...,100% of stick
+//   ARC has 2 segments at each side, break point is symmetrical
+#define CURVE_EXP	     0
+#define CURVE_CRV	     1
+#define CURVE_ARC	     2
+#define CURVE_POINTS	     9
+typedef struct {
+    s8	point[CURVE_POINTS];	// CRV values -100..100
+    u8	arc_x;			// ARC break point position 10..90%
+    u8	arc_y;			// ARC value at break point 0..100%
+} config_curve_s;
+
+// logical switches, evaluated each frame to bits of calc_switches,
+//   they can enable mixes, run timers and switch key functions
+#define LSW_NUM		     4
+#define LSW_OFF		     0
+#define LSW_GT		     1	// channel value > val
+#define LSW_LT		     2	// channel value < val
+#define LSW_KEY		     3	// key a (bit number of BTN_x) is held
+#define LSW_TIMER	     4	// timer a is alarmed
+#define LSW_AND		     5	// switches a and b are on
+#define LSW_OR		     6	// switch a or b is on
+#define LSW_FUNC_MAX	     6
+typedef struct {
+    u8	func:4;			// LSW_x
+    u8	inv:1;			// invert result
+    u8	unused:3;
+    u8	a:4;			// channel 1..8, key, timer or switch
+    u8	b:4;			// second switch for AND/OR
+    s8	val;			// -100..100 for channel compare
+    u8	kf;			// key function switched by it, 0 is OFF
+} config_lsw_s;
+
 
 
 
 // change MAGIC number when changing model config
 // also add code to setting default values
 // length must by multiple of 4 because of EEPROM/FLASH Word programming
-// 54(30 reserved) + 22(keys) + channels * 4 bytes = 108 for 8-channel fw
-#define CONFIG_MODEL_MAGIC  (0xd820 | (MAX_CHANNELS - 1))
+// 41 + 22(keys) + 20(mixes) + 22(curves) + 16(switches) + 12(ABS, throttle
+//   acceleration and modes) + 1(model) + 8(PPM input/output maps) + 2(crc)
+//   + channels * 4 bytes = 176 for 8-channel fw
+// crc must be last
+#define CONFIG_MODEL_MAGIC  (0xd8a0 | (MAX_CHANNELS - 1))
 typedef struct {
     u8	name[3];
     u8	reverse;			// bit for each channel
@@ -183,12 +240,41 @@ typedef struct {
     u8	unused:1;
     u8	channel_brake:4;		// channel for brake side of throttle
 
-    u8  unused2:4;
+    u8	curve_steering:2;		// CURVE_EXP/CRV/ARC
+    u8	curve_throttle:2;
     u8	unused3;
 
     config_key_mapping_s key_mapping;
 
-    u8	reserve[13];
+    config_mix_s mix[MIX_LINES];	// programmable mixes
+    config_curve_s curve[2];		// steering and throttle curves
+    config_lsw_s lsw[LSW_NUM];		// logical switches
+
+    // ABS settings, 0 is the same as before them
+    s8	abs_return;			// brake return 50 + -50..50 %
+    u8	abs_delay;			// onset delay 0..14 * 0.1s
+    u8	abs_cycle;			// cycle rate 1..30, 0 from abs_type
+    s8	abs_duty;			// -3..3, plus is longer full brake
+    u8	abs_trigger;			// trigger point 10..100%, 0 for 10%
+
+    // throttle acceleration over trigger point, 0 is off
+    u8	accel_fwd;			// forward acceleration speed 1..99
+    u8	accel_brk;			// brake acceleration speed 1..99
+    u8	accel_fwd_trig;			// trigger points 0..100%
+    u8	accel_brk_trig;
+
+    // throttle overlay modes, 0 is the same as before them
+    u8	thr_cut;			// BRK/cut position 1..100%, 0 for 100%
+    u8	idle_up;			// idle-up forward 0..50%
+    u8	neutral_brake;			// brake at neutral 0..50%, 0 is off
+
+    u8	model;				// model memory of this config, to
+					//   check actual model at poweron
+    u8	ppm_in_map[4];			// PPM input 1..8 or 0 for each
+					//   channel, 4 bits per channel
+    u8	ppm_out_map[4];			// output position 1..8 or 0 for
+					//   the same, 4 bits per channel
+    u16	crc;				// computed at eeprom/flash write
 } config_model_s;
 
 extern @near config_model_s config_model;
@@ -209,21 +295,14 @@ extern u8 config_get_MP(u8 index, u8 *pchannel_MP, s8 **pmulti_position);
 #include "eeprom.h"
 
 
-// number of model memories (eeprom + flash)
-
-#define CONFIG_MODEL_MAX_EEPROM	((EEPROM_SIZE - sizeof(config_global_s)) / \
-				 sizeof(config_model_s))
-// last eeprom model config will be used to temporarily store
-//   flash model config
-#define CONFIG_MODEL_TMP	(CONFIG_MODEL_MAX_EEPROM - 1)
-
-// DefaultInterrupt is last used place in FLASH, skip 1 byte ret instruction
-//   and compute how many models will fit to flash
-extern @interrupt void DefaultInterrupt (void);
-#define CONFIG_MODEL_MAX_FLASH	((u8)(((u16)0xffff - (u16)DefaultInterrupt) / \
-				 sizeof(config_model_s)))
-
-#define CONFIG_MODEL_MAX	(CONFIG_MODEL_MAX_EEPROM - 1 + CONFIG_MODEL_MAX_FLASH)
+// number of model memories (eeprom + flash), limited by showing model
+//   number (0..79), models are stored packed, so number of really stored
+//   models depends on their settings
+// EEPROM_PACK_SIZE / PACK_LEN_MAX + FLASH_PACK_SIZE / PACK_LEN_MAX - 2
+//   models fit always (one PACK_LEN_MAX record is FLASH reserve for
+//   moving records and one is for new copy of actual model written
+//   before old one is deleted), build script writes it to MANUAL
+#define CONFIG_MODEL_MAX	80
 
 
 // when name[0] is 0x00, that model memory was empty
@@ -243,12 +322,14 @@ extern void config_model_set_default(void);
 extern void config_model_read(void);
 extern u8 config_global_read(void);
 extern u8 *config_model_name(u8 model);
+extern u8 config_model_next(u8 model, u8 down);
 
 // write values to eeprom
-extern void config_set_model(u8 model);
+// 0 when no space for packed model
+extern u8 config_set_model(u8 model, u8 saveas);
 extern void config_model_save(void);
-#define config_global_save()  eeprom_write_global()
-#define config_empty_models() eeprom_empty_models()
+extern void config_global_save(void);
+extern void config_empty_models(void);
 
 
 #endif
@@ -19,19 +19,63 @@
 
 
 /*
-    first N models are stored at EEPROM after global config
-    last eeprom model config is used to temporarily store of FLASH model
-	memory, because EEPROM has 1M write cycles (flash 10K) and
+    actual model config is stored at EEPROM after global config,
+	because EEPROM has 1M write cycles (flash 10K) and
 	writing to FLASH stops microcontroller (EEPROM has ReadWhileWrite)
-    models at FLASH are stored from end of FLASH down to end of program
-    when FLASH model is selected, it is copied to temporary EEPROM place
-	and is stored back only after another model is selected
+    other models are packed (see config.c) and stored at EEPROM after
+	actual model and at FLASH from end of FLASH down to end of program,
+	EEPROM is used firstly
+    when model is selected, it is unpacked to actual model EEPROM place
+	and is packed back only after another model is selected, so its
+	packed copy is last known-good copy
+    packed models are written as log from top of each area down,
+	new version of model is appended and only then previous one
+	is marked as deleted, deleted records are reused for new ones,
+	when there is no place, records are moved over deleted ones,
+	each record is copied before its old place is deleted, part
+	of FLASH is kept free for moving records
+    journal of often changed values (trims, selected model) is at the
+	end of EEPROM, see config.c
+    lap log is before journal, it is a ring of lap times written
+	one word at time without waiting for end of programming,
+	see menu_timer.c
+    global and model configs have CRC at last 2 bytes, it is computed
+	during write, global config has shadow copy after it
 */
 
 
 
 #include <string.h>
 #include "eeprom.h"
+#include "ppm.h"
+
+
+
+
+
+// CRC-16-CCITT
+
+static u16 crc16(u16 crc, u8 val) {
+    u8 i;
+    crc ^= (u16)val << 8;
+    for (i = 8; i; i--) {
+	if (crc & 0x8000)  crc = (crc << 1) ^ 0x1021;
+	else		   crc <<= 1;
+    }
+    return crc;
+}
+
+// check CRC at last 2 bytes of record
+u8 eeprom_check(void *ram_addr, u16 length) {
+    u8 *addr = ram_addr;
+    u16 crc = CRC_INIT;
+
+    length -= 2;
+    do {
+	crc = crc16(crc, *addr++);
+    } while (--length);
+    return (u8)(crc == *(u16 *)addr);
+}
 
 
 
@@ -44,19 +88,21 @@
 }
 
 
-void eeprom_read_global(void) {
+// read global config, use shadow copy when it is corrupted
+u8 eeprom_read_global(void) {
     eeprom_read(EEPROM_CONFIG_GLOBAL, &config_global, sizeof(config_global_s));
+    if (eeprom_check(&config_global, sizeof(config_global_s)))  return 1;
+    eeprom_read(EEPROM_CONFIG_GLOBAL_SHADOW, &config_global,
+		sizeof(config_global_s));
+    if (!eeprom_check(&config_global, sizeof(config_global_s)))  return 0;
+    // repair global config
+    eeprom_write_global();
+    return 1;
 }
 
 
-void eeprom_read_model(u8 model) {
-    u8 size = sizeof(config_model_s);
-    eeprom_read(EEPROM_CONFIG_MODEL + model * size, &config_model, size);
-}
-
-void flash_read_model(u8 model) {
-    u8 size = sizeof(config_model_s);
-    eeprom_read((u8 *)(0 - (model + 1) * size), &config_model, size);
+void eeprom_read_model(void) {
+    eeprom_read(EEPROM_CONFIG_MODEL, &config_model, sizeof(config_model_s));
 }
 
 
@@ -94,14 +140,44 @@ static void eeprom_make_readonly(void *addr) {
 }
 
 
-static void eeprom_write(u8 *ee_addr, u8 *ram_addr, u16 length) {
+// lap log word is programmed in background, eeprom_write() is in progress
+static _Bool word_busy;
+static _Bool write_busy;
+
+// check end of background word programming, lock EEPROM after it
+u8 eeprom_idle(void) {
+    if (!word_busy)  return 1;
+    // reading of EndOfProgramming flag clears it
+    if (!BCHK(FLASH_IAPSR, 2))  return 0;
+    word_busy = 0;
+    BRES(FLASH_IAPSR, 3);
+    return 1;
+}
+
+
+// when crc set, compute CRC and store it to last 2 bytes
+static void eeprom_write(u8 *ee_addr, u8 *ram_addr, u16 length, u8 crc) {
+    u16 c = CRC_INIT;
+    while (!eeprom_idle())  pause();
+    write_busy = 1;
     eeprom_make_writable(ee_addr);
     // write only values, which are different, check and write at
     // Word mode (4 bytes)
     length /= 4;
     do {
+	if (crc) {
+	    c = crc16(c, ram_addr[0]);
+	    c = crc16(c, ram_addr[1]);
+	    if (length == 1)  *(u16 *)(ram_addr + 2) = c;
+	    else {
+		c = crc16(c, ram_addr[2]);
+		c = crc16(c, ram_addr[3]);
+	    }
+	}
 	if (*(u16 *)ee_addr != *(u16 *)ram_addr ||
 	    *(u16 *)(ee_addr + 2) != *(u16 *)(ram_addr + 2)) {
+	    // FLASH programming stops CPU, do it in PPM SYNC signal
+	    if ((u16)ee_addr >= 0x8000)  ppm_wait_sync();
 	    // enable Word programming
 	    BSET(FLASH_CR2, 6);
 	    BRES(FLASH_NCR2, 6);
@@ -117,58 +193,315 @@ static void eeprom_write(u8 *ee_addr, u8 *ram_addr, u16 length) {
 	ram_addr += 4;
     } while (--length);
     eeprom_make_readonly(ee_addr);
+    write_busy = 0;
 }
 
 
+// write global config and then its shadow copy
 void eeprom_write_global(void) {
-    eeprom_write(EEPROM_CONFIG_GLOBAL, (u8 *)&config_global, sizeof(config_global_s));
+    eeprom_write(EEPROM_CONFIG_GLOBAL, (u8 *)&config_global,
+		 sizeof(config_global_s), 1);
+    eeprom_write(EEPROM_CONFIG_GLOBAL_SHADOW, (u8 *)&config_global,
+		 sizeof(config_global_s), 1);
 }
 
 
-void eeprom_write_model(u8 model) {
-    u8 size = sizeof(config_model_s);
-    eeprom_write(EEPROM_CONFIG_MODEL + model * size, (u8 *)&config_model, size);
+void eeprom_write_model(void) {
+    eeprom_write(EEPROM_CONFIG_MODEL, (u8 *)&config_model,
+		 sizeof(config_model_s), 1);
 }
 
-void flash_write_model(u8 model) {
-    u8 size = sizeof(config_model_s);
-    eeprom_write((u8 *)(0 - (model + 1) * size), (u8 *)&config_model, size);
+
+void eeprom_write_word(u8 *ee_addr, u8 *ram_addr) {
+    eeprom_write(ee_addr, ram_addr, 4, 0);
 }
 
 
+void eeprom_write_journal(u8 idx, journal_entry_s *entry) {
+    eeprom_write(EEPROM_JOURNAL + idx * sizeof(journal_entry_s), (u8 *)entry,
+		 sizeof(journal_entry_s), 0);
+}
 
 
-// initialize model memories to empty one
-void eeprom_empty_models(void) {
-    u8 cnt = CONFIG_MODEL_MAX_EEPROM;
-    config_model_s *cm = (config_model_s *)EEPROM_CONFIG_MODEL;
+// set all journal entries to zero (invalid check)
+void eeprom_empty_journal(void) {
+    journal_entry_s entry;
+    u8 i;
 
-    // EEPROM first
-    eeprom_make_writable(cm);
-    // write 0x00 to first letter of each model config
-    do {
-	if (cm->name[0] != CONFIG_MODEL_EMPTY) {
-	    cm->name[0] = CONFIG_MODEL_EMPTY;
-	    // wait for EOP
-	    while (!BCHK(FLASH_IAPSR, 2))  pause();
+    memset(&entry, 0, sizeof(entry));
+    for (i = 0; i < EEPROM_JOURNAL_SIZE / sizeof(journal_entry_s); i++)
+	eeprom_write_journal(i, &entry);
+}
+
+
+
+
+// start writing lap log entry, do not wait for end of programming,
+//   return 0 when EEPROM is busy now
+u8 eeprom_write_laplog(u8 idx, laplog_entry_s *entry) {
+    u8 *ee_addr = EEPROM_LAPLOG + idx * sizeof(laplog_entry_s);
+    u8 *ram_addr = (u8 *)entry;
+
+    if (write_busy || !eeprom_idle())  return 0;
+    eeprom_make_writable(ee_addr);
+    // enable Word programming
+    BSET(FLASH_CR2, 6);
+    BRES(FLASH_NCR2, 6);
+    // write 4-byte value, EEPROM is locked at eeprom_idle()
+    ee_addr[0] = ram_addr[0];
+    ee_addr[1] = ram_addr[1];
+    ee_addr[2] = ram_addr[2];
+    ee_addr[3] = ram_addr[3];
+    word_busy = 1;
+    return 1;
+}
+
+
+// set all lap log entries to zero (empty)
+void eeprom_empty_laplog(void) {
+    laplog_entry_s entry;
+    u8 i;
+
+    memset(&entry, 0, sizeof(entry));
+    for (i = 0; i < EEPROM_LAPLOG_SIZE / sizeof(laplog_entry_s); i++)
+	eeprom_write(EEPROM_LAPLOG + i * sizeof(laplog_entry_s), (u8 *)&entry,
+		     sizeof(laplog_entry_s), 0);
+}
+
+
+
+
+// packed models
+
+static u8 *pack_found;
+static const u8 pack_zero[4];
+
+// max. number of moved records at one allocation
+#define PACK_MOVES	(2 * CONFIG_MODEL_MAX)
+
+@inline static u8 *pack_top(u8 area) {
+    return area ? FLASH_PACK_TOP : EEPROM_PACK_TOP;
+}
+
+@inline static u16 pack_size(u8 area) {
+    return area ? FLASH_PACK_SIZE : EEPROM_PACK_SIZE;
+}
+
+#define pack_trailer(area, off)  (pack_top(area) - (off) - PACK_TRAILER)
+
+// length of record at given offset, 0 at end of log
+static u8 pack_len(u8 area, u16 off) {
+    u8 *trailer = pack_trailer(area, off);
+    u16 size = pack_size(area);
+    u8 len;
+
+    if (off + 4 > size)  return 0;
+    len = trailer[1];
+    if (!trailer[0] || len < 4 || (len & 3) || len > size - off)  return 0;
+    return len;
+}
+
+// walk records of area, return size of used part and set pack_found
+//   to last record with given id
+static u16 pack_scan(u8 area, u8 id) {
+    u16 off = 0;
+    u8 len;
+
+    while ((len = pack_len(area, off))) {
+	if (pack_trailer(area, off)[0] == id)
+	    pack_found = pack_top(area) - off - len;
+	off += len;
+    }
+    return off;
+}
+
+// set trailer of record ending before "end", rest of its word is kept
+static void pack_set_trailer(u8 *end, u8 id, u8 len) {
+    u8 word[4];
+
+    memcpy(word, end - 4, 2);
+    word[2] = id;
+    word[3] = len;
+    eeprom_write_word(end - 4, word);
+}
+
+
+// find last record of model
+u8 *eeprom_pack_find(u8 model) {
+    pack_found = NULL;
+    pack_scan(0, (u8)(model + 1));
+    pack_scan(1, (u8)(model + 1));
+    return pack_found;
+}
+
+
+// make one deleted record with given length at offset off from
+//   successive deleted records (they must be long enough), deleted
+//   record containing its end is split and all before it are joined,
+//   log is valid after each step
+static void pack_dead(u8 area, u16 off, u8 length) {
+    u8 *top = pack_top(area);
+    u16 o = off, end = off + length;
+    u8 len;
+
+    while (o + (len = pack_len(area, o)) < end)  o += len;
+    if (o + len != end) {
+	pack_set_trailer(top - end, PACK_DELETED, (u8)(o + len - end));
+	pack_set_trailer(top - o, PACK_DELETED, (u8)(end - o));
+    }
+    while ((len = pack_len(area, off)) != length)
+	pack_set_trailer(top - off, PACK_DELETED,
+			 (u8)(len + pack_len(area, off + len)));
+}
+
+// find place for new record at area, successive deleted records are
+//   used when they are long enough, deleted records at end of log are
+//   changed to free space
+// at FLASH, "reserve" bytes are kept free for moving records
+// trailer of new record must be written as last, till then this place
+//   is still end of log or deleted record
+static u8 *pack_place(u8 area, u8 length, u8 reserve) {
+    u8 *top = pack_top(area);
+    u16 off = 0, run_off = 0, run = 0, end = 0;
+    u8 len;
+
+    while ((len = pack_len(area, off))) {
+	if (pack_trailer(area, off)[0] != PACK_DELETED) {
+	    run = 0;
+	    end = off + len;
+	}
+	else {
+	    if (!run)  run_off = off;
+	    run += len;
+	}
+	off += len;
+	// deleted records at end of log are used as free space below
+	if (run >= length && pack_len(area, off)) {
+	    pack_dead(area, run_off, length);
+	    return top - run_off - length;
+	}
+    }
+
+    if (end != off)  eeprom_write_word(top - end - 4, (u8 *)pack_zero);
+    if (!area)  reserve = 0;
+    if (pack_size(area) - end < length + reserve)  return NULL;
+    // zero trailers at place for new record and at new end of log
+    off = end + length;
+    eeprom_write_word(top - off, (u8 *)pack_zero);
+    if (pack_size(area) - off >= 4)
+	eeprom_write_word(top - off - 4, (u8 *)pack_zero);
+    return top - off;
+}
+
+// copy record to new place, its trailer is at last word
+static void pack_copy(u8 *dst, u8 *src, u8 length) {
+    u8 i;
+    u8 word[4];
+
+    for (i = 0; i < length; i += 4) {
+	memcpy(word, src + i, 4);
+	eeprom_write_word(dst + i, word);
+    }
+}
+
+// move first record after deleted ones up over them, new copy is
+//   written firstly and only then old one is deleted, so after power
+//   loss there can be two same copies, but nothing is lost
+// when deleted records are shorter than it, it is copied to other
+//   place (reserved part of FLASH at worst) and from it back
+// return 0 when nothing was moved
+static u8 pack_compact(u8 area) {
+    u8 *top = pack_top(area);
+    u16 off = 0, run_off = 0, run = 0;
+    u8 len;
+    u8 *src, *rec;
+
+    while ((len = pack_len(area, off))) {
+	if (pack_trailer(area, off)[0] == PACK_DELETED) {
+	    if (!run)  run_off = off;
+	    run += len;
+	}
+	else if (run) {
+	    src = top - off - len;
+	    if (run < len) {
+		rec = pack_place(0, len, 0);
+		if (!rec)  rec = pack_place(1, len, 0);
+		if (!rec) {
+		    run = 0;
+		    off += len;
+		    continue;
+		}
+		pack_copy(rec, src, len);
+		pack_set_trailer(src + len, PACK_DELETED, len);
+		src = rec;
+	    }
+	    pack_dead(area, run_off, len);
+	    pack_copy(top - run_off - len, src, len);
+	    pack_set_trailer(src + len, PACK_DELETED, len);
+	    return 1;
 	}
-	cm++;
-    } while (--cnt);
-    eeprom_make_readonly(cm);
-
-    // FLASH second
-    cnt = CONFIG_MODEL_MAX_FLASH;
-    cm = (config_model_s *)(-sizeof(config_model_s));
-    eeprom_make_writable(cm);
-    // write 0x00 to first letter of each model config
+	off += len;
+    }
+    return 0;
+}
+
+// return place for new record, EEPROM is used firstly, when there is
+//   no place, records are moved over deleted ones
+u8 *eeprom_pack_alloc(u8 length) {
+    u8 area, i = PACK_MOVES;
+    u8 *rec;
+
     do {
-	if (cm->name[0] != CONFIG_MODEL_EMPTY) {
-	    cm->name[0] = CONFIG_MODEL_EMPTY;
-	    // wait for EOP
-	    while (!BCHK(FLASH_IAPSR, 2))  pause();
+	for (area = 0; area < 2; area++)
+	    if ((rec = pack_place(area, length, PACK_LEN_MAX)))  return rec;
+    } while ((pack_compact(0) || pack_compact(1)) && --i);
+    return NULL;
+}
+
+
+// mark all records of model (except keep) as deleted
+void eeprom_pack_delete(u8 model, u8 *keep) {
+    u8 area, len;
+    u16 off;
+
+    for (area = 0; area < 2; area++) {
+	off = 0;
+	while ((len = pack_len(area, off))) {
+	    if (pack_trailer(area, off)[0] == (u8)(model + 1) &&
+		pack_top(area) - off - len != keep)
+		pack_set_trailer(pack_top(area) - off, PACK_DELETED, len);
+	    off += len;
+	}
+    }
+}
+
+
+
+
+// call func for each model record
+void eeprom_pack_walk(void (*func)(u8 model, u8 *rec)) {
+    u8 area, len, id;
+    u16 off;
+
+    for (area = 0; area < 2; area++) {
+	off = 0;
+	while ((len = pack_len(area, off))) {
+	    id = pack_trailer(area, off)[0];
+	    if (id != PACK_DELETED)
+		func((u8)(id - 1), pack_top(area) - off - len);
+	    off += len;
 	}
-	cm--;
-    } while (--cnt);
-    eeprom_make_readonly(cm);
+    }
 }
 
+
+
+
+// initialize model memories to empty one
+void eeprom_empty_models(void) {
+    // actual model
+    eeprom_write_word(EEPROM_CONFIG_MODEL, (u8 *)pack_zero);
+    // end of log at top of both areas
+    eeprom_write_word(EEPROM_PACK_TOP - 4, (u8 *)pack_zero);
+    eeprom_write_word(FLASH_PACK_TOP - 4, (u8 *)pack_zero);
+}
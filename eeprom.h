@@ -29,22 +29,85 @@
 #define EEPROM_SIZE   0x400
 
 
-// position of global config
+// position of global config and its shadow copy
 #define EEPROM_CONFIG_GLOBAL  (u8 *)EEPROM_START
-
-
-// position of models config
-#define EEPROM_CONFIG_MODEL  (u8 *)(EEPROM_CONFIG_GLOBAL + sizeof(config_global_s))
-
-
-extern void eeprom_read_global(void);
-extern void eeprom_read_model(u8 model);
-extern void flash_read_model(u8 model);
+#define EEPROM_CONFIG_GLOBAL_SHADOW  (u8 *)(EEPROM_CONFIG_GLOBAL + \
+					    sizeof(config_global_s))
+
+
+// position of actual model config
+#define EEPROM_CONFIG_MODEL  (u8 *)(EEPROM_CONFIG_GLOBAL_SHADOW + \
+				    sizeof(config_global_s))
+
+
+// journal of often changed values at the end of eeprom, 14 entries
+#define EEPROM_JOURNAL_SIZE  56
+#define EEPROM_JOURNAL  (u8 *)(EEPROM_START + EEPROM_SIZE - EEPROM_JOURNAL_SIZE)
+
+// log of lap times before journal, 64 entries
+#define EEPROM_LAPLOG_SIZE  256
+#define EEPROM_LAPLOG  (u8 *)(EEPROM_JOURNAL - EEPROM_LAPLOG_SIZE)
+
+// packed models are stored between actual model and lap log and at FLASH
+//   from end of FLASH down to end of program
+// DefaultInterrupt is last used place in FLASH, skip 1 byte ret instruction
+#define EEPROM_PACK_TOP  EEPROM_LAPLOG
+#define EEPROM_PACK_SIZE (u16)(EEPROM_PACK_TOP - EEPROM_CONFIG_MODEL - \
+			       sizeof(config_model_s))
+extern @interrupt void DefaultInterrupt (void);
+#define FLASH_PACK_TOP   (u8 *)0
+#define FLASH_PACK_SIZE  (u16)((0 - (u16)DefaultInterrupt - 1) & 0xfffc)
+
+// packed model is stored as bitmap of bytes different from model defaults,
+//   followed by that different bytes and by model number and length
+//   of record (aligned to 4 bytes), this trailer is written as last
+#define PACK_BITMAP	((sizeof(config_model_s) + 7) / 8)
+#define PACK_TRAILER	2
+#define PACK_DELETED	0xff
+// length of record with cnt different bytes
+#define PACK_LEN(cnt)  (u8)((PACK_BITMAP + (cnt) + PACK_TRAILER + 3) & 0xfc)
+#define PACK_LEN_MAX   PACK_LEN(sizeof(config_model_s))
+
+// one journal entry, 4 bytes because of EEPROM Word programming
+typedef struct {
+    u8	seq;		// sequence number
+    u8	id;		// offset at model config or JRN_MODEL/JRN_SYNC
+    u8	val;
+    u8	check;		// ~(seq + id + val)
+} journal_entry_s;
+
+// one lap log entry, also 4 bytes
+typedef struct {
+    u8	seq;		// sequence number 1..255, 0 at empty entry
+    u8	session;	// timer ID at bit 7, session number at bits 0-6
+    u16	time;		// lap time in 0.01s
+} laplog_entry_s;
+
+
+// CRC of config records, it is at last 2 bytes of record
+#define CRC_INIT  0xffff
+extern u8 eeprom_check(void *ram_addr, u16 length);
+
+extern u8 eeprom_read_global(void);  // 0 when global and shadow are corrupted
+extern void eeprom_read_model(void);
 extern void eeprom_write_global(void);
-extern void eeprom_write_model(u8 model);
-extern void flash_write_model(u8 model);  // to flash starting at 0
+extern void eeprom_write_model(void);
+extern void eeprom_write_word(u8 *ee_addr, u8 *ram_addr);
 extern void eeprom_empty_models(void);
 
+// packed models
+extern u8 *eeprom_pack_find(u8 model);
+extern u8 *eeprom_pack_alloc(u8 length);
+extern void eeprom_pack_delete(u8 model, u8 *keep);
+extern void eeprom_pack_walk(void (*func)(u8 model, u8 *rec));
+extern void eeprom_write_journal(u8 idx, journal_entry_s *entry);
+extern void eeprom_empty_journal(void);
+
+// lap log
+extern u8 eeprom_write_laplog(u8 idx, laplog_entry_s *entry);
+extern u8 eeprom_idle(void);
+extern void eeprom_empty_laplog(void);
+
 
 #endif
 
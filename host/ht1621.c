@@ -0,0 +1,252 @@
+/*
+    ht1621 - HT1621B emulator for host build
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// LCD pins are checked after each lcd_interrupt() call (or at register
+//   access with HT_SYNC), data bit is latched at rising WR/ when CS/
+//   is low, as HT1621B does
+// screen is rendered from segment memory using segment addresses
+//   from lcd_seg_* arrays and LS_* symbols, independently from
+//   precompiled tables used by lcd.c
+
+#define HT_REGS		// registers without HT_SYNC access check
+#include <string.h>
+#include "ht1621.h"
+#include "lcd.h"
+
+
+// HT1621B modes and used commands
+#define HT_COMMAND	0b100
+#define HT_WRITE	0b101
+#define HT_SYS_DIS	0b00000000
+#define HT_SYS_EN	0b00000001
+#define HT_LCD_OFF	0b00000010
+#define HT_LCD_ON	0b00000011
+
+// pins
+#define CS	BCHK(PC_ODR, 3)
+#define WR	BCHK(PF_ODR, 4)
+#define DATA	BCHK(PE_ODR, 5)
+
+
+ht1621_s ht;
+
+static u8 ht_cs;		// last CS/ and WR/ pins
+static u8 ht_wr;
+static u8 ht_mode;		// mode of actual transaction
+static u8 ht_pos;		// bit position in transaction
+static u8 ht_addr;		// actual write address
+static u16 ht_word;		// bits decoded so far
+
+
+// set pins to idle state and clear controller
+void ht_init(void) {
+    BSET(PC_ODR, 3);
+    BSET(PF_ODR, 4);
+    memset(&ht, 0, sizeof(ht));
+    ht_cs = ht_wr = 1;
+}
+
+
+// decode one bit of transaction
+static void ht_bit(u8 bit) {
+    ht.bits++;
+    ht_word = (u16)((ht_word << 1) | bit);
+    ht_pos++;
+    if (ht_pos == 3) {
+	ht_mode = (u8)ht_word;
+	ht_word = 0;
+	if (ht_mode != HT_COMMAND && ht_mode != HT_WRITE)  ht.errors++;
+    }
+    else if (ht_mode == HT_COMMAND) {
+	// 9 bits of command, more commands can follow
+	if (ht_pos < 12)  return;
+	switch ((u8)(ht_word >> 1)) {
+	    case HT_SYS_DIS:  ht.sys_en = 0;  ht.lcd_on = 0;  break;
+	    case HT_SYS_EN:   ht.sys_en = 1;  break;
+	    case HT_LCD_OFF:  ht.lcd_on = 0;  break;
+	    case HT_LCD_ON:   ht.lcd_on = 1;  break;
+	}
+	ht_pos = 3;
+	ht_word = 0;
+    }
+    else if (ht_mode == HT_WRITE) {
+	// 6 bits of address, then 4 bits of data for each successive address
+	if (ht_pos == 9) {
+	    ht_addr = (u8)(ht_word & 0x1f);
+	    ht_word = 0;
+	}
+	else if (ht_pos > 9 && !((u8)(ht_pos - 9) & 3)) {
+	    ht.ram[ht_addr] = (u8)(ht_word & 0x0f);
+	    ht_addr = (u8)((ht_addr + 1) & 0x1f);
+	    ht_word = 0;
+	}
+    }
+}
+
+
+// check pins changed by lcd_interrupt()
+static void ht_pins(void) {
+    u8 cs = (u8)(CS ? 1 : 0);
+    u8 wr = (u8)(WR ? 1 : 0);
+
+    if (!cs && ht_cs) {
+	// start of transaction
+	ht.trans++;
+	ht_pos = 0;
+	ht_word = 0;
+	ht_mode = 0;
+    }
+    else if (cs && !ht_cs) {
+	// end of transaction, command or data must be complete
+	if (ht_mode == HT_COMMAND ? ht_pos != 3
+	    : ht_pos < 9 || ((u8)(ht_pos - 9) & 3))  ht.errors++;
+    }
+    if (!cs && wr && !ht_wr)  ht_bit((u8)(DATA ? 1 : 0));
+    ht_cs = cs;
+    ht_wr = wr;
+}
+
+
+#ifndef HT_SYNC
+// call lcd_interrupt() while timer4 is running
+void ht_run(void) {
+    while (BCHK(TIM4_CR1, 0)) {
+	lcd_interrupt();
+	ht.intrs++;
+	ht_pins();
+    }
+}
+#else
+// bits were already sent, check last pins state
+void ht_run(void) {
+    ht_pins();
+}
+
+// pins are checked before each access to CS/ port and TIM4_SR, so
+//   every state set by lcd.c is seen before it is changed, timer
+//   is always expired
+volatile unsigned char *ht_sync_reg(volatile unsigned char *reg) {
+    ht_pins();
+    if (reg == &TIM4_SR)  BSET(TIM4_SR, 0);
+    return reg;
+}
+#endif
+
+
+// run LCD task and send all its bits to controller
+void ht_flush(void) {
+    pause();
+    ht_run();
+}
+
+
+
+
+// rendering of screen
+
+static const u8 *ht_seg_chars[3] = {
+    lcd_seg_char1, lcd_seg_char2, lcd_seg_char3
+};
+
+typedef struct {
+    u8 pos;
+    char *name;
+} ht_symbol_s;
+
+static const ht_symbol_s ht_menus[] = {
+    { LS_MENU_MODEL, "MODEL" },
+    { LS_MENU_NAME,  "NAME" },
+    { LS_MENU_REV,   "REV" },
+    { LS_MENU_EPO,   "EPO" },
+    { 0, "" },
+    { LS_MENU_TRIM,  "TRIM" },
+    { LS_MENU_DR,    "D/R" },
+    { LS_MENU_EXP,   "EXP" },
+    { LS_MENU_ABS,   "ABS" },
+    { 0, NULL }
+};
+
+static const ht_symbol_s ht_symbols[] = {
+    { LS_SYM_MODELNO, "MODELNO" },
+    { LS_SYM_CHANNEL, "CH" },
+    { LS_SYM_LEFT,    "<" },
+    { LS_SYM_RIGHT,   ">" },
+    { LS_SYM_PERCENT, "%" },
+    { LS_SYM_DOT,     "DOT" },
+    { LS_SYM_VOLTS,   "V" },
+    { LS_SYM_LOWPWR,  "LOWPWR" },
+    { 0, NULL }
+};
+
+
+// segment pos (as at lcd_segment()) is on
+static u8 ht_seg(u8 pos) {
+    return (u8)((ht.ram[pos & 0x1f] >> (pos >> 6)) & 1);
+}
+
+
+// write names of symbols, not showed ones as dots, pos 0 is line break
+static void ht_names(FILE *f, const ht_symbol_s *s) {
+    char *c;
+
+    for (; s->name; s++) {
+	if (!s->pos)  continue;		// line break
+	for (c = s->name; *c; c++)
+	    fputc(ht_seg(s->pos) ? *c : '.', f);
+	fputc(s[1].name && s[1].pos ? ' ' : '\n', f);
+    }
+}
+
+
+// 7seg is 3 lines at left of first 3 char rows, chars are 5x7 dots
+void ht_render(FILE *f) {
+    const u8 *s7 = lcd_seg_7seg;
+    u8 row, i, col;
+
+    ht_names(f, ht_menus);
+    for (row = 0; row < LCD_CHAR_ROWS; row++) {
+	// 7seg segments: left top/bottom, top, middle, bottom,
+	//   right top/bottom
+	switch (row) {
+	    case 0:
+		fprintf(f, " %c ", ht_seg(s7[2]) ? '_' : ' ');
+		break;
+	    case 1:
+		fprintf(f, "%c%c%c", ht_seg(s7[0]) ? '|' : ' ',
+			ht_seg(s7[3]) ? '_' : ' ', ht_seg(s7[5]) ? '|' : ' ');
+		break;
+	    case 2:
+		fprintf(f, "%c%c%c", ht_seg(s7[1]) ? '|' : ' ',
+			ht_seg(s7[4]) ? '_' : ' ', ht_seg(s7[6]) ? '|' : ' ');
+		break;
+	    default:
+		fputs("   ", f);
+	}
+	for (i = 0; i < 3; i++) {
+	    fputs("  ", f);
+	    for (col = 0; col < LCD_CHAR_COLS; col++)
+		fputc(ht_seg(ht_seg_chars[i][col * LCD_CHAR_ROWS + row])
+		      ? '#' : '.', f);
+	}
+	fputc('\n', f);
+    }
+    ht_names(f, ht_symbols);
+    fprintf(f, "LCD %s\n", ht.sys_en && ht.lcd_on ? "on" : "off");
+}
+
@@ -0,0 +1,56 @@
+/*
+    ht1621 - HT1621B emulator for host build, include file
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _HT1621_INCLUDED
+#define _HT1621_INCLUDED
+
+
+#include <stdio.h>
+#include "gt3b.h"
+
+
+// state of emulated LCD controller
+typedef struct {
+    u8  ram[32];		// segment memory, first sent data bit is bit 3
+    u8  sys_en;			// SYS_EN command received
+    u8  lcd_on;			// LCD_ON command received
+    u16 bits;			// bits sent to controller
+    u16 trans;			// transactions (CS/ low) sent
+    u16 intrs;			// lcd_interrupt() calls
+    u16 errors;			// unknown commands, incomplete data
+} ht1621_s;
+extern ht1621_s ht;
+
+// timer4 interrupt of lcd.c
+extern void lcd_interrupt(void);
+
+// set pins to idle state and clear controller
+extern void ht_init(void);
+// call lcd_interrupt() while timer4 is running and decode pins,
+//   with HT_SYNC only decode pins
+extern void ht_run(void);
+// run LCD task and send all its bits to controller
+extern void ht_flush(void);
+// write LCD screen as text, without LCD traffic which differs
+//   between lcd.c versions
+extern void ht_render(FILE *f);
+
+
+#endif
+
@@ -0,0 +1,54 @@
+/*
+    iostm8s - registers used by lcd.c for host build
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#define HT_REGS
+#include "iostm8s.h"
+
+
+#define REG(name)  volatile unsigned char name
+
+REG(PC_ODR);
+REG(PC_DDR);
+REG(PC_CR1);
+REG(PC_CR2);
+REG(PD_ODR);
+REG(PD_DDR);
+REG(PD_CR1);
+REG(PD_CR2);
+REG(PE_ODR);
+REG(PE_DDR);
+REG(PE_CR1);
+REG(PE_CR2);
+REG(PF_ODR);
+REG(PF_DDR);
+REG(PF_CR1);
+REG(PF_CR2);
+
+REG(CLK_PCKENR1);
+
+REG(TIM2_CNTRH);
+REG(TIM2_CNTRL);
+
+REG(TIM4_CR1);
+REG(TIM4_IER);
+REG(TIM4_SR);
+REG(TIM4_CNTR);
+REG(TIM4_PSCR);
+REG(TIM4_ARR);
+
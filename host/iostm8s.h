@@ -0,0 +1,70 @@
+/*
+    iostm8s - registers used by lcd.c for host build
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _IOSTM8S_INCLUDED
+#define _IOSTM8S_INCLUDED
+
+
+// registers are plain variables, HT1621B emulator watches LCD pins
+//   after each lcd_interrupt() call
+// with HT_SYNC (baseline lcd.c sending bits without interrupts) it
+//   watches them at each access to PC_ODR (CS/ pin) and TIM4_SR,
+//   TIM4_SR shows always expired timer
+#define REG(name)  extern volatile unsigned char name
+
+REG(PC_ODR);
+REG(PC_DDR);
+REG(PC_CR1);
+REG(PC_CR2);
+REG(PD_ODR);
+REG(PD_DDR);
+REG(PD_CR1);
+REG(PD_CR2);
+REG(PE_ODR);
+REG(PE_DDR);
+REG(PE_CR1);
+REG(PE_CR2);
+REG(PF_ODR);
+REG(PF_DDR);
+REG(PF_CR1);
+REG(PF_CR2);
+
+REG(CLK_PCKENR1);
+
+REG(TIM2_CNTRH);
+REG(TIM2_CNTRL);
+
+REG(TIM4_CR1);
+REG(TIM4_IER);
+REG(TIM4_SR);
+REG(TIM4_CNTR);
+REG(TIM4_PSCR);
+REG(TIM4_ARR);
+
+#undef REG
+
+#if defined(HT_SYNC) && !defined(HT_REGS)
+extern volatile unsigned char *ht_sync_reg(volatile unsigned char *reg);
+#define PC_ODR   (*ht_sync_reg(&PC_ODR))
+#define TIM4_SR  (*ht_sync_reg(&TIM4_SR))
+#endif
+
+
+#endif
+
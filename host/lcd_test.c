@@ -0,0 +1,195 @@
+/*
+    lcd_test - LCD screens rendered by HT1621B emulator
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// screens are made by the same lcd_* calls as menus do, each one
+//   is rendered to text file in given directory, number of LCD bits
+//   and transactions needed to show it from previous screen is printed
+// snapshots are made by baseline lcd.c (HT_SYNC), screens of actual
+//   lcd.c must be the same
+// segment memory decoded by LCD_STATS at lcd.c is checked against emulator
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lcd.h"
+#include "ht1621.h"
+
+
+extern void lcd_init(void);
+
+#ifndef HT_SYNC
+// from LCD_STATS at lcd.c
+extern volatile u16 lcd_stat_bits;
+extern volatile u32 lcd_stat_intrs;
+extern u8 lcd_stat_ram[32];
+#endif
+
+static char *out_dir;
+static u8 failed;
+
+
+// send LCD changes and write rendered screen to file
+static void screen(char *name) {
+    char path[256];
+    FILE *f;
+
+    ht_flush();
+    if (ht.errors) {
+	fprintf(stderr, "%s: %u HT1621B protocol errors\n", name, ht.errors);
+	failed = 1;
+    }
+#ifndef HT_SYNC
+    if (memcmp(lcd_stat_ram, ht.ram, sizeof(ht.ram))) {
+	fprintf(stderr, "%s: LCD_STATS segment memory differs\n", name);
+	failed = 1;
+    }
+    if (lcd_stat_bits != ht.bits) {
+	fprintf(stderr, "%s: LCD_STATS bits %u, emulator bits %u\n",
+		name, lcd_stat_bits, ht.bits);
+	failed = 1;
+    }
+    if (lcd_stat_intrs != ht.intrs) {
+	fprintf(stderr, "%s: LCD_STATS interrupts %lu, emulator %u\n",
+		name, (unsigned long)lcd_stat_intrs, ht.intrs);
+	failed = 1;
+    }
+#endif
+    printf("%-13s %4u bits, %2u transactions, %4u interrupts\n",
+	   name, ht.bits, ht.trans, ht.intrs);
+
+    snprintf(path, sizeof(path), "%s/%s.txt", out_dir, name);
+    if (!(f = fopen(path, "w"))) {
+	perror(path);
+	exit(2);
+    }
+    ht_render(f);
+    fclose(f);
+
+    // count next screen from zero
+    ht.bits = ht.trans = ht.intrs = 0;
+#ifndef HT_SYNC
+    lcd_stat_bits = 0;
+    lcd_stat_intrs = 0;
+#endif
+}
+
+
+// as at menu.c
+static void show_model_number(u8 model) {
+    lcd_7seg((u8)(model % 10));
+    lcd_segment(LS_SYM_RIGHT, (u8)((u8)(model / 10) & 1));
+    lcd_segment(LS_SYM_LEFT, (u8)((u8)(model / 20) & 1));
+    lcd_segment(LS_SYM_PERCENT, (u8)((u8)(model / 40) & 1));
+    lcd_segment(LS_SYM_MODELNO, LS_ON);
+}
+
+// as at menu_common.c
+static void menu_clear_symbols(void) {
+    lcd_segment(LS_SYM_MODELNO, LS_OFF);
+    lcd_segment(LS_SYM_DOT, LS_OFF);
+    lcd_segment(LS_SYM_VOLTS, LS_OFF);
+    lcd_segment(LS_SYM_PERCENT, LS_OFF);
+    lcd_segment(LS_SYM_LEFT, LS_OFF);
+    lcd_segment(LS_SYM_RIGHT, LS_OFF);
+    lcd_segment(LS_SYM_CHANNEL, LS_OFF);
+}
+
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+	fprintf(stderr, "usage: %s output_directory\n", argv[0]);
+	return 2;
+    }
+    out_dir = argv[1];
+
+    ht_init();
+    lcd_init();
+    lcd_clear();
+    screen("init");
+
+    lcd_set_full_on();
+    screen("full_on");
+
+    // main screen with model name
+    lcd_clear();
+    lcd_menu(LM_MODEL);
+    lcd_segment(LS_SYM_CHANNEL, LS_OFF);
+    lcd_segment(LS_SYM_DOT, LS_OFF);
+    lcd_segment(LS_SYM_VOLTS, LS_OFF);
+    show_model_number(12);
+    lcd_chars((u8 *)"M12");
+    lcd_update();
+    screen("main_name");
+
+    // main screen with battery voltage
+    lcd_segment(LS_SYM_CHANNEL, LS_OFF);
+    lcd_segment(LS_SYM_DOT, LS_ON);
+    lcd_segment(LS_SYM_VOLTS, LS_ON);
+    show_model_number(12);
+    lcd_char_num3(84);
+    lcd_update();
+    screen("main_battery");
+
+    // model select menu, chars blinking
+    menu_clear_symbols();
+    show_model_number(12);
+    lcd_chars((u8 *)"M12");
+    lcd_chars_blink_mask(LB_SPC, 0xff);
+    lcd_update();
+    screen("model_menu");
+
+    // blink time with blinking chars off
+    lcd_blink_cnt = LCD_BLNK_CNT_BLANK;
+    lcd_blink_flag = 1;
+    awake(LCD);
+    screen("model_blink");
+
+    // trim of steering
+    lcd_blink_cnt = 0;
+    menu_clear_symbols();
+    lcd_menu(LM_TRIM);
+    lcd_segment(LS_SYM_CHANNEL, LS_ON);
+    lcd_7seg(1);
+    lcd_char_num2_lbl(-15, (u8 *)"LNR");
+    lcd_update();
+    screen("trim");
+
+    // endpoint of channel 3 at left side
+    menu_clear_symbols();
+    lcd_menu(LM_EPO);
+    lcd_segment(LS_SYM_CHANNEL, LS_ON);
+    lcd_7seg(3);
+    lcd_segment(LS_SYM_LEFT, LS_ON);
+    lcd_segment(LS_SYM_PERCENT, LS_ON);
+    lcd_char_num3(120);
+    lcd_update();
+    screen("endpoint");
+
+    // ABS brake return, value -150 shows special char -1
+    menu_clear_symbols();
+    lcd_menu(LM_ABS);
+    lcd_7seg(L7_R);
+    lcd_segment(LS_SYM_PERCENT, LS_ON);
+    lcd_char_num3(-150);
+    lcd_update();
+    screen("abs_return");
+
+    return failed;
+}
+
@@ -0,0 +1,78 @@
+/*
+    task - task switching for host build
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// only one task (LCD) is used at host, it is run from pause() of test
+//   program, at stop() it returns back by longjmp()
+// pause() called from task (full LCD queue) sends queued bits
+//   to HT1621B emulator instead of switching to other task
+
+#include <setjmp.h>
+#include <stddef.h>
+#include "task.h"
+#include "ht1621.h"
+
+
+// pointer to current task, NULL when test program is running
+TCB *ptid;
+
+static TCB *task_tcb;
+static void (*task_func)(void);
+static jmp_buf task_jmp;
+
+
+// activate task - remember its function and set AWAKE
+void _do_activate(TCB *task, u8 *stack, u16 stack_size,
+		  void (*function)(void)) {
+    task_tcb = task;
+    task_func = function;
+    task->status = _AWAKE;
+}
+
+
+// build - do not run this yet
+void _do_build(TCB *task) {
+    task->status = _ASLEEP;
+}
+
+
+// run task while it is AWAKE, it starts again at its function,
+//   it is OK for task loops doing only "while (1) { ...; stop(); }"
+static void task_run(void) {
+    while (task_tcb && task_tcb->status == _AWAKE) {
+	ptid = task_tcb;
+	ptid->status = _ASLEEP;
+	if (!setjmp(task_jmp))  task_func();
+	ptid = NULL;
+    }
+}
+
+
+// pause test program to run task, or task to send LCD queue
+void pause(void) {
+    if (ptid)  ht_run();
+    else  task_run();
+}
+
+
+// stop task and return back to test program
+void stop(void) {
+    ptid->status = _ASLEEP;
+    longjmp(task_jmp, 1);
+}
+
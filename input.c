@@ -34,6 +34,7 @@
 #include "calc.h"
 #include "lcd.h"
 #include "timer.h"
+#include "buzzer.h"
 
 
 
@@ -112,6 +113,9 @@ u16 buttons_state;		// actual combined last buttons state
 static u8 buttons_autorepeat;	// autorepeat enable for TRIMs and D/R
 @near static u8 buttons_timer[12];	// autorepeat/long press buttons timers
 static u8 encoder_timer;	// for rotate encoder slow/fast
+// time_ms of press for first 12 keys, corrected by debounce time
+#define BTN_DEBOUNCE_MS		10
+@near static u16 buttons_time[12];
 
 // variables representing pressed buttons
 u16 buttons;
@@ -132,6 +136,15 @@ void button_reset_nolong(u16 btn) {
 }
 
 
+// return time_ms when (first of) btn was pressed
+u16 button_time(u16 btn) {
+    u8 i;
+    for (i = 0; i < 12; i++, btn >>= 1)
+	if (btn & 1)  return buttons_time[i];
+    return time_ms;
+}
+
+
 /**
    @brief
      set autorepeat
@@ -221,6 +234,7 @@ static void read_keys(void) {
 		    // last not pressed
 		    if (bs) {
 			// now pressed, set it pressed and set autorepeat delay
+			buttons_time[i] = time_ms - BTN_DEBOUNCE_MS;
 			buttons |= bit;
 			buttons_timer[i] = BTN_AUTOREPEAT_DELAY;
 		    }
@@ -250,6 +264,7 @@ static void read_keys(void) {
 		// last not pressed
 		if (bs) {
 		    // now pressed, set long press delay
+		    buttons_time[i] = time_ms - BTN_DEBOUNCE_MS;
 		    buttons_timer[i] = cg.long_press_delay;
 		}
 		// do nothing for now not pressed
@@ -403,6 +418,57 @@ static void check_throttle_trigger(void) {
 
 
 
+// start/stop timers by logical switches, awake MENU to display timers
+//   and to switch key functions of logical switches
+// switches are changing only after model is loaded, so after timers
+//   are connected to their config
+static u8 last_switches;
+static void check_switches(void) {
+    u8 sw = calc_switches;
+    u8 changed = (u8)(sw ^ last_switches);
+    u8 i, tbit, sbit, type;
+
+    last_switches = sw;
+    for (i = 0, tbit = 1; i < TIMER_NUM; i++, tbit <<= 1) {
+	type = TIMER_TYPE(i);
+	if (!TIMER_SW(i) || type == TIMER_OFF || type == TIMER_LAPCNT)
+	    continue;
+	sbit = (u8)(1 << (TIMER_SW(i) - 1));
+	if (!(changed & sbit))  continue;
+	if (sw & sbit)  menu_timer_running |= tbit;
+	else		menu_timer_running &= (u8)~tbit;
+    }
+    awake(MENU);
+}
+
+
+
+
+// handle timer alarms flagged at timer interrupt
+static void check_timer_alarms(void) {
+    u8 i, tbit, alarms;
+
+    sim();
+    alarms = menu_timer_alarm_new;
+    menu_timer_alarm_new = 0;
+    rim();
+
+    for (i = 0, tbit = 1; i < TIMER_NUM; i++, tbit <<= 1) {
+	if (!(alarms & tbit))  continue;
+	buzzer_play(buzzer_alarm, 1);
+	// backlight on for at least 5 seconds
+	if (!lcd_bck_on || lcd_bck_count < 5)  backlight_on_sec(5);
+	// switch main screen
+	menu_main_screen = (u8)(MS_TIMER0 + i);
+	awake(MENU);
+    }
+}
+
+
+
+
+
+
 // read first ADC values
 #define ADC_BUFINIT(id) \
     adc_buffer ## id ## [1] = adc_buffer ## id ## [2] = \
@@ -429,6 +495,9 @@ static void input_loop(void) {
     while (1) {
 	read_keys();
 	if (menu_timer_throttle)  check_throttle_trigger();
+	if (menu_timer_alarm_new)  check_timer_alarms();
+	if (calc_switches != last_switches)  check_switches();
+	menu_timer_laplog_flush();
 	check_inactivity();
 	update_battery();
 	stop();
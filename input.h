@@ -78,6 +78,9 @@ extern void button_reset(u16 btn);
 extern void button_reset_nolong(u16 btn);
 #define btnr_nolong(mask)  button_reset_nolong(mask)
 
+// time (time_ms) of button press
+extern u16 button_time(u16 btn);
+
 
 // set autorepeat
 extern void button_autorepeat(u8 btn);
@@ -79,45 +79,176 @@
 
 /* low level LCD routines and initialization */
 
-// send cnt bits to LCD controller, only low bits of "bits" are used
-// use timer4 to get 600kHz clock for driving WR/ signal
-// timer is used in one-pulse mode and is started after each WR/ change,
-//   so there will always be minimal required length of pulse also
-//   when interrupted by some interrupt
-static void lcd_send_bits(u8 cnt, u16 bits) {
-    // shift bits to high-bits
-    bits <<= (u8)(16 - cnt);
-    WR0;
-    BSET(TIM4_CR1, 0);			// start timer
-    WR0;				// optimize hack
-    do {
-	if (bits & 0x8000) {
+// LCD controller is driven in background by timer4 interrupt,
+//   LCD task only puts items (up to 16 bits) to queue
+// each interrupt is half of WR/ clock, it is much slower than original
+//   600kHz clock to not overload CPU by interrupts, interrupt with
+//   Cosmic entry/exit takes about 60-80 CPU cycles, at 20kHz it is
+//   about 8% of CPU only when LCD is sending (about 14ms for update
+//   of all segments), see README.internal
+#define LCD_PSCR	4	// timer clock / 16
+#define LCD_ARR		(u8)(KHZ / 16 / 20 - 1)	// 20kHz intr, 10kHz WR/ clock
+#define LCD_QUEUE	8	// must be power of 2, LCD_QUEUE-1 usable items
+#define LCD_END		0x80	// last item of transaction, CS/ goes up after
+typedef struct {
+    u8  cnt;			// number of bits + LCD_END flag
+    u16 bits;			// bits shifted to high-bits
+} lcd_item_s;
+static @near lcd_item_s lcd_queue[LCD_QUEUE];
+static volatile u8 lcd_q_head;	// next free item, changed only by task
+static volatile u8 lcd_q_tail;	// next item to send, changed only by intr
+static u8 lcd_tx_cnt;		// half-bits to send from actual item
+static u8 lcd_tx_end;		// actual item is last in transaction
+static u16 lcd_tx_bits;		// rest of actual item bits
+
+#ifdef LCD_STATS
+// LCD bus statistics and copy of HT1621B segment memory decoded
+//   from sent bits, to be examined by debugger
+volatile u16 lcd_stat_bits;	// bits sent to LCD controller
+volatile u16 lcd_stat_trans;	// transactions (CS/ low) sent
+volatile u16 lcd_stat_last;	// bits queued by last LCD task action
+volatile u16 lcd_stat_max;	// maximum of lcd_stat_last
+volatile u32 lcd_stat_intrs;	// number of lcd_interrupt calls
+volatile u32 lcd_stat_ticks;	// TIM2 ticks (2 CPU cycles) in lcd_interrupt
+u8 lcd_stat_ram[32];		// decoded segment memory
+static u8 lcd_stat_pos;		// bit position in transaction
+static u8 lcd_stat_addr;	// actual write address
+static u16 lcd_stat_word;	// bits decoded so far
+
+// decode one sent bit
+static void lcd_stat_bit(u8 bit) {
+    lcd_stat_bits++;
+    lcd_stat_word = (lcd_stat_word << 1) | bit;
+    if (++lcd_stat_pos == 9) {
+	// command ID and address, only WRITE is decoded
+	if ((u8)(lcd_stat_word >> 6) == HT_WRITE)
+	    lcd_stat_addr = (u8)(lcd_stat_word & 0x3f);
+	else  lcd_stat_addr = 0xff;
+	lcd_stat_word = 0;
+    }
+    else if (lcd_stat_pos > 9 && !((u8)(lcd_stat_pos - 9) & 3)) {
+	// 4 bits of data, next address
+	if (lcd_stat_addr < 32)
+	    lcd_stat_ram[lcd_stat_addr++] = (u8)(lcd_stat_word & 0x0f);
+	lcd_stat_word = 0;
+    }
+}
+
+static u16 lcd_stat_tim2(void) {
+    u8 hi = TIM2_CNTRH;		// reading high byte latches low byte
+    return (u16)((u16)hi << 8 | TIM2_CNTRL);
+}
+#endif
+
+
+// timer4 interrupt, send one half of bit
+@interrupt void lcd_interrupt(void) {
+    lcd_item_s *q;
+#ifdef LCD_STATS
+    u16 start = lcd_stat_tim2();
+    lcd_stat_intrs++;
+#endif
+    BRES(TIM4_SR, 0);			// clear intr flag
+
+    if (lcd_tx_cnt & 1) {
+	// second half of bit, rising WR/ latches data bit
+	WR1;
+	lcd_tx_cnt--;
+    }
+    else if (!lcd_tx_cnt && lcd_tx_end) {
+	// end of transaction, keep CS/ up for at least one interrupt
+	CS1;
+	lcd_tx_end = 0;
+    }
+    else if (!lcd_tx_cnt && lcd_q_tail == lcd_q_head) {
+	// nothing more to send, stop timer
+	BRES(TIM4_CR1, 0);
+    }
+    else {
+	if (!lcd_tx_cnt) {
+	    // actual item done, get next item from queue
+	    q = &lcd_queue[lcd_q_tail];
+	    lcd_tx_cnt = (u8)((q->cnt & ~LCD_END) << 1);
+	    lcd_tx_end = (u8)(q->cnt & LCD_END);
+	    lcd_tx_bits = q->bits;
+	    lcd_q_tail = (u8)((lcd_q_tail + 1) & (LCD_QUEUE - 1));
+#ifdef LCD_STATS
+	    if (BCHK(PC_ODR, 3)) {
+		// CS/ was high, new transaction
+		lcd_stat_trans++;
+		lcd_stat_pos = 0;
+		lcd_stat_word = 0;
+	    }
+#endif
+	    CS0;
+	}
+
+	// first half of bit, set data
+	WR0;
+	if (lcd_tx_bits & 0x8000) {
 	    DATA1;
 	}
 	else {
 	    DATA0;
 	}
-	bits <<= 1;			// to next bit
-	while (!BCHK(TIM4_SR, 0));	// wait for timer
-	WR1;
-	BRES(TIM4_SR, 0);		// clear intr flag
-	BSET(TIM4_CR1, 0);		// start timer
-	if (!--cnt)  break;
-	while (!BCHK(TIM4_SR, 0));	// wait for timer
-	WR0;
-	BRES(TIM4_SR, 0);		// clear intr flag
-	BSET(TIM4_CR1, 0);		// start timer
-    } while (1);
-    while (!BCHK(TIM4_SR, 0));		// wait for timer
-    BRES(TIM4_SR, 0);			// clear intr flag
+#ifdef LCD_STATS
+	lcd_stat_bit((u8)(lcd_tx_bits & 0x8000 ? 1 : 0));
+#endif
+	lcd_tx_bits <<= 1;
+	lcd_tx_cnt--;
+    }
+
+#ifdef LCD_STATS
+    // timer counts from 0 to 1ms
+    start = lcd_stat_tim2() - start;
+    if ((s16)start < 0)  start += KHZ / 2;
+    lcd_stat_ticks += start;
+#endif
+}
+
+
+// put one item to queue and start sending, when queue is full, let other
+//   tasks run until interrupt sends something
+// at lcd_init() time, it must not be full, because interrupts are
+//   not enabled yet
+static void lcd_queue_put(u8 cnt, u16 bits) {
+    u8 head = (u8)((lcd_q_head + 1) & (LCD_QUEUE - 1));
+    lcd_item_s *q = &lcd_queue[lcd_q_head];
+    while (head == lcd_q_tail)  pause();
+    q->cnt = cnt;
+    q->bits = bits;
+    lcd_q_head = head;
+    BSET(TIM4_CR1, 0);			// start timer if not running
+}
+
+
+// send cnt bits to LCD controller, only low bits of "bits" are used
+// last item is held back to be able to mark it by LCD_END in lcd_send_end()
+static u8 lcd_pend_cnt;
+static u16 lcd_pend_bits;
+static void lcd_send_bits(u8 cnt, u16 bits) {
+#ifdef LCD_STATS
+    lcd_stat_last += cnt;
+    if (lcd_stat_last > lcd_stat_max)  lcd_stat_max = lcd_stat_last;
+#endif
+    if (lcd_pend_cnt)  lcd_queue_put(lcd_pend_cnt, lcd_pend_bits);
+    lcd_pend_cnt = cnt;
+    // shift bits to high-bits
+    lcd_pend_bits = bits << (u8)(16 - cnt);
+}
+
+
+// end of transaction, CS/ will go up after last item
+static void lcd_send_end(void) {
+    lcd_queue_put((u8)(lcd_pend_cnt | LCD_END), lcd_pend_bits);
+    lcd_pend_cnt = 0;
 }
 
 
 // send command to LCD
 static void lcd_command(u8 cmd) {
-    CS0;
     lcd_send_bits(12, (HT_COMMAND << 9) | (cmd << 1));
-    CS1;
+    lcd_send_end();
 }
 
 
@@ -141,13 +272,13 @@ void lcd_init(void) {
 
     // initialize timer 4 used to time WR/ signal
     BSET(CLK_PCKENR1, 4);     // enable clock to TIM4
-    TIM4_CR1 = 0b00001100;    // no auto-reload, one-pulse,URS-overflow, disable
-    TIM4_IER = 0;             // no interrupts
-    TIM4_PSCR = 0;            // prescaler = 1
-    TIM4_ARR = 24;            // it will be about 600kHz for WR/ signal
+    TIM4_CR1 = 0b00000100;    // no preload, URS-overflow, disable
+    TIM4_IER = 1;             // update interrupt enable
+    TIM4_PSCR = LCD_PSCR;     // prescaler = 16
+    TIM4_ARR = LCD_ARR;       // interrupt for each half of WR/ clock
     TIM4_CNTR = 0;	      // reset timer value
 
-    // initialize HT1621B
+    // initialize HT1621B, commands will be sent after enabling interrupts
     lcd_command(HT_BIAS_13 | (0b10 << HT_BIAS_SHIFT));  // BIAS 1/3, 4 COMs
     lcd_command(HT_RC_256K);  // clock RC 256kHz
     lcd_command(HT_SYS_DIS);  // OSC+BIAS off
@@ -190,22 +321,51 @@ static void lcd_seg_comms(u8 segment, u8 comms) {
 }
 
 
+// test if segment was modified
+static u8 lcd_seg_modified(u8 segment) {
+    if (segment < 16)
+	return (u8)(lcd_modified_segments & ((u16)1 << segment) ? 1 : 0);
+    return (u8)(lcd_modified_segments2 & ((u16)1 << (u8)(segment - 16))
+		? 1 : 0);
+}
+
+
 // send changed LCD segments to LCD controller
+// run of changed segments is sent as one successive-address write,
+//   unchanged segments in gap up to LCD_GAP are sent also, because
+//   they are cheaper (4 bits each) than new write (CS + 9 bits)
+#define LCD_GAP  2
 static void lcd_seg_update(void) {
-    u8 i;
-    u16 bit;
-    for (i = 0; i < MAX_SEGMENT; i++) {
-	if (i < 16) {
-	    bit = (u16)1 << i;
-	    if (!(lcd_modified_segments & bit))  continue;
-	}
-	else {
-	    bit = (u16)1 << (u8)(i - 16);
-	    if (!(lcd_modified_segments2 & bit))  continue;
+    u8 i = 0;
+    u8 start, last, cnt;
+    u16 bits;
+
+    while (i < MAX_SEGMENT) {
+	if (!lcd_seg_modified(i)) {
+	    i++;
+	    continue;
 	}
-	CS0;
-	lcd_send_bits(13, (HT_WRITE << 10) | (i << 4) | lcd_segments[i]);
-	CS1;
+	// find end of run
+	start = last = i;
+	while (++i < MAX_SEGMENT && i <= (u8)(last + LCD_GAP + 1))
+	    if (lcd_seg_modified(i))  last = i;
+
+	// write address and then data of all segments in run,
+	//   4 segments at once
+	lcd_send_bits(9, (HT_WRITE << 6) | start);
+	bits = 0;
+	cnt = 0;
+	do {
+	    bits = (bits << 4) | lcd_segments[start];
+	    if (++cnt == 4) {
+		lcd_send_bits(16, bits);
+		bits = 0;
+		cnt = 0;
+	    }
+	} while (++start <= last);
+	if (cnt)  lcd_send_bits((u8)(cnt << 2), bits);
+	lcd_send_end();
+	i = (u8)(last + 1);
     }
     lcd_modified_segments = lcd_modified_segments2 = 0;
 }
@@ -227,6 +387,24 @@ static u8 lcd_bitmap[MAX_SEGMENT];
 volatile _Bool lcd_blink_flag;		// set in timer interrupt in blink times
 volatile u8 lcd_blink_cnt;		// blink counter updated in timer
 volatile _Bool lcd_blink_something;  // there are some blink segments
+// bit flags of segments, which have some blink bits in lcd_bitmap
+static u16 lcd_blink_segments;
+static u16 lcd_blink_segments2;
+
+
+// update blink flag of segment from its blink bits
+static void lcd_blink_mark(u8 segment) {
+    u16 *bs = &lcd_blink_segments;
+    u8 blink = (u8)(lcd_bitmap[segment] & 0xf0);
+    u16 bit;
+    if (segment >= 16) {
+	bs = &lcd_blink_segments2;
+	segment -= 16;
+    }
+    bit = (u16)1 << segment;
+    if (blink)  *bs |= bit;
+    else  *bs &= ~bit;
+}
 
 
 
@@ -246,6 +424,7 @@ void lcd_segment(u8 pos, u8 on_off) {
     }
     // turn blinking off for this bit
     lcd_bitmap[segment] &= (u8)~(com_bit << 4);
+    lcd_blink_mark(segment);
 }
 
 
@@ -269,52 +448,42 @@ void lcd_segment_blink(u8 pos, u8 on_off) {
     else {
 	lcd_bitmap[segment] &= (u8)~blnk_bit;
     }
+    lcd_blink_mark(segment);
 }
 
 
-// show normal (non-blinked) LCD bitmap
-static void lcd_show_normal(void) {
-    u8 i;
-    for (i = 0; i < MAX_SEGMENT; i++) {
-	lcd_seg_comms(i, (u8)(lcd_bitmap[i] & 0xf));
-    }
-    lcd_seg_update();
-}
-
-
-// show blinked LCD bitmap
-static void lcd_show_inverted(u8 update) {
-    u8 i, c;
-    u8 inverted = 0;
-    for (i = 0; i < MAX_SEGMENT; i++) {
-	c = lcd_bitmap[i];
-	if (!(c & 0xf0)) {
-	    // nothing to invert, but if update, send non-inverted
-	    if (update)
-		lcd_seg_comms(i, (u8)(c & 0xf));
-	    continue;
-	}
-	lcd_seg_comms(i, (u8)((u8)(c & 0xf) ^ (u8)((u8)(c & 0xf0) >> 4)));
-	inverted = 1;
-    }
-    if (inverted)  lcd_seg_update();
-    else {
-	lcd_blink_something = 0;	// nothing was blinked
-	if (update)  lcd_seg_update();	// but if update requested, do it
+// show segments from bitmap, inverted by blink bits when inverted is set
+// segments are given by bit flags, starting at segment "segment"
+static void lcd_show_segments(u16 segs, u8 segment, u8 inverted) {
+    u8 c;
+    for (; segs; segs >>= 1, segment++) {
+	if (!(segs & 1))  continue;
+	c = lcd_bitmap[segment];
+	if (inverted)  c ^= (u8)(c >> 4);
+	lcd_seg_comms(segment, (u8)(c & 0xf));
     }
 }
 
 
 // do LCD item blinking at regular timer times
+// at update, all segments are refreshed, at blink times only
+//   segments with some blink bits
 static void lcd_blink(u8 update) {
+    u8 inverted = (u8)(lcd_blink_cnt >= LCD_BLNK_CNT_BLANK);
     lcd_blink_flag = 0;
-    if (update)  lcd_update_flag = 0;
-    if (lcd_blink_cnt < LCD_BLNK_CNT_BLANK) {
-	lcd_show_normal();
+    if (update) {
+	lcd_update_flag = 0;
+	lcd_show_segments(0xffff, 0, inverted);
+	lcd_show_segments(0xffff, 16, inverted);
     }
     else {
-	lcd_show_inverted(update);
+	lcd_show_segments(lcd_blink_segments, 0, inverted);
+	lcd_show_segments(lcd_blink_segments2, 16, inverted);
     }
+    // nothing more to blink
+    if (!(lcd_blink_segments | lcd_blink_segments2))
+	lcd_blink_something = 0;
+    lcd_seg_update();
 }
 
 
@@ -339,14 +508,14 @@ static void lcd_clr_set(u16 data) {
     lcd_modified_segments = 0;
     lcd_modified_segments2 = 0;
     lcd_blink_something = 0;
-    CS0;
+    lcd_blink_segments = lcd_blink_segments2 = 0;
     // set lcd address to 0
     lcd_send_bits(9, HT_WRITE << 6);
     // send 32x 4bits of data in group of 16 bits
     for (i = 0; i < MAX_SEGMENT / 4; i++) {
 	lcd_send_bits(16, data);
     }
-    CS1;
+    lcd_send_end();
 }
 
 
@@ -355,8 +524,10 @@ static void lcd_clr_set(u16 data) {
 
 // main LCD task, handle update/cle/set/blink requests
 static void lcd_loop(void) {
-    u8 i;
     while (1) {
+#ifdef LCD_STATS
+	lcd_stat_last = 0;
+#endif
 	if (lcd_clr_flag)		lcd_clr_set(0);
 	else if (lcd_set_flag)		lcd_clr_set(0xffff);
 	else if (lcd_update_flag)	lcd_blink(1);
@@ -422,15 +593,64 @@ static const struct lcd_items_s {
 
 
 
+// chars precompiled from lcd_seg_char1..3, each column of char is using
+//   COMs 0-2 of one segment (bitmap bits 6-4) and all COMs of
+//   another segment (bitmap bits 3-0)
+static const u8 lcd_char_seg[3][2 * LCD_CHAR_COLS] = {
+    { 29, 30, 31, 17, 16,   26, 25, 24, 23, 22 },
+    { 15, 14, 13, 12, 11,   21, 20, 19, 18,  0 },
+    { 10,  9,  8,  7,  6,    1,  2,  3,  4,  5 },
+};
+// bitmap bits 6-4 to COMs 0-2
+static const u8 lcd_char_comA[8] = {
+    0, 4, 2, 6, 1, 5, 3, 7
+};
+// bitmap bits 3-0 to COMs 2,1,0,3
+static const u8 lcd_char_comB[16] = {
+    0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15
+};
+
+// special (fake) bitmaps LB_EMPTY..LB_FULL, checked at both sides to work
+//   also at host build, where real addresses are above them
+#define lcd_fake_bitmap(bitmap) \
+    (u8)((bitmap) >= LB_EMPTY && (bitmap) <= LB_FULL)
+
+// set char element id to given bitmap, blinking is turned off
+static void lcd_set_char(u8 id, u8 *bitmap) {
+    const u8 *seg = lcd_char_seg[id];
+    u8 fake_bitmap = lcd_fake_bitmap(bitmap);
+    u8 bm = (u8)((u16)bitmap & 0xff);
+    u8 i;
+    u8 *bms;
+    for (i = 0; i < LCD_CHAR_COLS; i++, seg++) {
+	if (!fake_bitmap)  bm = *bitmap++;
+	// COM3 of first segment is other symbol, leave it (and its blink)
+	bms = &lcd_bitmap[*seg];
+	*bms = (u8)((u8)(*bms & 0x88) | lcd_char_comA[(u8)(bm >> 4) & 7]);
+	lcd_blink_mark(*seg);
+	lcd_bitmap[seg[LCD_CHAR_COLS]] = lcd_char_comB[bm & 0x0f];
+	lcd_blink_mark(seg[LCD_CHAR_COLS]);
+    }
+}
+
+
 // set LCD element id to given bitmap
 void lcd_set(u8 id, u8 *bitmap) {
-    struct lcd_items_s *li = &lcd_items[id];
-    u8 *seg = li->segments;	// actual lcd segment pointer
-    u8 sp = *seg++;		// actual lcd segment
-    u8 bits = li->bits;		// number of bits in bitmap
+    struct lcd_items_s *li;
+    u8 *seg;			// actual lcd segment pointer
+    u8 sp;			// actual lcd segment
+    u8 bits;			// number of bits in bitmap
     u8 bitpos = 8;		// bit position in bitmap byte
-    u8 fake_bitmap = (u8)(bitmap >= (u8 *)0xff00);
+    u8 fake_bitmap = lcd_fake_bitmap(bitmap);
     u8 bm;			// actual byte of bitmap
+    if (id <= LCHR3) {
+	lcd_set_char(id, bitmap);
+	return;
+    }
+    li = &lcd_items[id];
+    seg = li->segments;
+    sp = *seg++;
+    bits = li->bits;
     if (fake_bitmap) {
 	// special addresses are actually bitmap for all segments
 	bm = (u8)((u16)bitmap & 0xff);
@@ -232,11 +232,17 @@ static void menu_channel(u8 end_channel, u8 use_adc, u8 forced_values,
 
 // select model/save model as (to selected model position)
 #define MIN(a, b)  (a < b ? a : b)
+static _Bool model_saveas;
 static void menu_model_func(u8 action, u8 *model) {
-    if (action == MCA_ID_CHG)
-	*model = (u8)menu_change_val((s16)*model, 0,
-				     MIN(CONFIG_MODEL_MAX, 80) - 1,
-				     MODEL_FAST, 1);
+    if (action == MCA_ID_CHG) {
+	if (!model_saveas && btnl(BTN_ROT_ALL))
+	    // fast rotate skips to next used model memory
+	    *model = config_model_next(*model, (u8)(btn(BTN_ROT_L) ? 1 : 0));
+	else
+	    *model = (u8)menu_change_val((s16)*model, 0,
+					 MIN(CONFIG_MODEL_MAX, 80) - 1,
+					 MODEL_FAST, 1);
+    }
 
     show_model_number(*model);
     lcd_chars(config_model_name(*model));
@@ -245,21 +251,29 @@ static void menu_model_func(u8 action, u8 *model) {
 static void menu_model(u8 saveas) {
     u8 model = cg.model;
 
+    model_saveas = saveas;
     if (saveas)  lcd_set_blink(LMENU, LB_SPC);
 
     menu_common(menu_model_func, &model, MCF_ENTER);
 
     // if new model choosed, save it
     if (model != cg.model) {
-	config_set_model(model);
-	if (saveas) {
-	    // save to new model position
-	    config_model_save();
+	// hold actual PPM values for whole model change, actual model
+	//   is packed and new one loaded, FLASH writes stop CPU
+	calc_hold = 1;
+	if (!config_set_model(model, saveas)) {
+	    // no space for packed model, stay at actual one
+	    calc_hold = 0;
+	    lcd_chars("FUL");
+	    lcd_update();
+	    buzzer_on(30, 30, 3);
+	    delay_menu_always(2);
 	}
-	else {
+	else if (!saveas) {
 	    // load selected model
 	    menu_load_model();
 	}
+	calc_hold = 0;
     }
     if (saveas)  lcd_set_blink(LMENU, LB_OFF);
 }
@@ -476,26 +490,142 @@ static void menu_channel_value(void) {
 
 
 // set abs: OFF, SLO(6), NOR(4), FAS(3)
-// pulses between full brake and 1/2 brake and only when enought brake applied
+// pulses between full brake and reduced brake and only when enought
+//   brake applied, other ABS settings follow type
 static const u8 abs_labels[][4] = {
     "OFF", "SLO", "NOR", "FAS"
 };
 #define ABS_LABEL_SIZE  (sizeof(abs_labels) / 4)
 
-static void menu_abs_func(u8 action, void *p) {
-    // change value
-    if (action == MCA_SET_CHG)
+static void abs_type(u8 action) {
+    // change value, use cycle rate of this type
+    if (action == MLA_CHG) {
 	cm.abs_type = (u8)menu_change_val(cm.abs_type, 0, ABS_LABEL_SIZE-1, 1, 1);
-    
+	cm.abs_cycle = 0;
+    }
+
     // show value
     lcd_segment(LS_SYM_CHANNEL, LS_ON);
     lcd_7seg(2);
     lcd_chars(abs_labels[cm.abs_type]);
 }
 
+// amount of brake return in pulses
+static void abs_return(u8 action) {
+    if (action == MLA_CHG)
+	cm.abs_return = (s8)(menu_change_val(cm.abs_return + 50, 0, 100,
+					     ABS_FAST, 0) - 50);
+    lcd_7seg(L7_R);
+    lcd_char_num3(cm.abs_return + 50);
+    lcd_segment(LS_SYM_PERCENT, LS_ON);
+}
+
+// delay before first pulse in 0.1s
+static void abs_delay(u8 action) {
+    if (action == MLA_CHG)
+	cm.abs_delay = (u8)menu_change_val(cm.abs_delay, 0, 14, 1, 0);
+    lcd_7seg(L7_D);
+    lcd_char_num3(cm.abs_delay);
+    lcd_segment(LS_SYM_DOT, LS_ON);
+}
+
+// cycle rate 1..30, SLO/NOR/FAS are 10/20/30
+static void abs_cycle(u8 action) {
+    u8 val = (u8)(cm.abs_cycle ? cm.abs_cycle : cm.abs_type * 10);
+    if (action == MLA_CHG)
+	cm.abs_cycle = val = (u8)menu_change_val(val, 1, 30, ABS_FAST, 0);
+    lcd_7seg(L7_C);
+    lcd_char_num3(val);
+}
+
+// duty ratio, plus is longer full brake
+static void abs_duty(u8 action) {
+    if (action == MLA_CHG)
+	cm.abs_duty = (s8)menu_change_val(cm.abs_duty, -3, 3, 1, 0);
+    lcd_7seg(L7_U);
+    lcd_char_num3(cm.abs_duty);
+}
+
+// trigger point in percent of brake
+static void abs_trigger(u8 action) {
+    u8 val = (u8)(cm.abs_trigger ? cm.abs_trigger : 10);
+    if (action == MLA_CHG)
+	cm.abs_trigger = val = (u8)menu_change_val(val, 10, 100, ABS_FAST, 0);
+    lcd_7seg(L7_T);
+    lcd_char_num3(val);
+    lcd_segment(LS_SYM_PERCENT, LS_ON);
+}
+
+// throttle acceleration speed for forward (left arrow) and brake side,
+//   OFF or 1..99
+static void accel_speed(u8 action) {
+    u8 *addr = menu_id == 6 ? &cm.accel_fwd : &cm.accel_brk;
+    if (action == MLA_CHG)
+	*addr = (u8)menu_change_val(*addr, 0, 99, SPEED_FAST, 0);
+    lcd_7seg(L7_A);
+    lcd_segment((u8)(menu_id == 6 ? LS_SYM_LEFT : LS_SYM_RIGHT), LS_ON);
+    if (!*addr)  lcd_chars("OFF");
+    else {
+	lcd_char_num3(*addr);
+	lcd_segment(LS_SYM_PERCENT, LS_ON);
+    }
+}
+
+// throttle acceleration trigger points
+static void accel_trigger(u8 action) {
+    u8 *addr = menu_id == 8 ? &cm.accel_fwd_trig : &cm.accel_brk_trig;
+    if (action == MLA_CHG)
+	*addr = (u8)menu_change_val(*addr, 0, 100, ABS_FAST, 0);
+    lcd_7seg(L7_P);
+    lcd_segment((u8)(menu_id == 8 ? LS_SYM_LEFT : LS_SYM_RIGHT), LS_ON);
+    lcd_char_num3(*addr);
+    lcd_segment(LS_SYM_PERCENT, LS_ON);
+}
+
+// brake/engine cut key position at brake side
+static void thr_cut(u8 action) {
+    u8 val = (u8)(cm.thr_cut ? cm.thr_cut : 100);
+    if (action == MLA_CHG)
+	cm.thr_cut = val = (u8)menu_change_val(val, 1, 100, ABS_FAST, 0);
+    lcd_7seg(L7_B);
+    lcd_char_num3(val);
+    lcd_segment(LS_SYM_PERCENT, LS_ON);
+}
+
+// idle-up forward and neutral brake amount, OFF or 1..50%
+static void thr_idle_nbrake(u8 action) {
+    u8 *addr = menu_id == 11 ? &cm.idle_up : &cm.neutral_brake;
+    if (action == MLA_CHG)
+	*addr = (u8)menu_change_val(*addr, 0, 50, ABS_FAST, 0);
+    lcd_7seg((u8)(menu_id == 11 ? L7_I : L7_N));
+    if (!*addr)  lcd_chars("OFF");
+    else {
+	lcd_char_num3(*addr);
+	lcd_segment(LS_SYM_PERCENT, LS_ON);
+    }
+}
+
+static const menu_list_t abs_funcs[] = {
+    abs_type,
+    abs_return,
+    abs_delay,
+    abs_cycle,
+    abs_duty,
+    abs_trigger,
+    accel_speed,
+    accel_speed,
+    accel_trigger,
+    accel_trigger,
+    thr_cut,
+    thr_idle_nbrake,
+    thr_idle_nbrake,
+};
+
 static void menu_abs(void) {
-    menu_common(menu_abs_func, NULL, (u8)(MCF_ENTER | MCF_SET_ONLY));
+    menu_list(abs_funcs, sizeof(abs_funcs) / sizeof(void *), MCF_NONE);
     config_model_save();
+    calc_abs_prepare();
+    calc_throttle_prepare();
 }
 
 
@@ -682,8 +812,9 @@ void menu_init(void) {
     }
 
     // reset global timers
-    menu_timer_clear(0, 1);
-    menu_timer_clear(1, 1);
+    menu_timer_init();
+    // and restore last laps from lap log
+    menu_timer_laplog_init();
 
     // read model config from eeprom
     menu_load_model();
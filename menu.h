@@ -22,6 +22,7 @@
 
 
 #include "gt3b.h"
+#include "config.h"
 
 
 
@@ -39,6 +40,8 @@
 #define EXPO_FAST	5
 #define CHANNEL_FAST	5
 #define MIX_FAST	5
+#define CURVE_FAST	5
+#define ABS_FAST	5
 #define SPEED_FAST	5
 #define TIMER_ALARM_FAST 5
 #define LAP_SHOW_FAST	5
@@ -68,7 +71,11 @@ extern s8  menu_4WS_mix;		// mix -100..100
 extern _Bool menu_4WS_crab;		// when 1, crab steering
 extern s8  menu_DIG_mix;		// mix -100..100
 extern u8  menu_MP_index[];		// index of MultiPosition channels
-extern _Bool menu_brake;		// when 1, full brake is applied
+extern u8  menu_throttle_mode;		// active throttle overlay modes
+#define THM_BRAKE	0x01		//   brake/cut key
+#define THM_HOLD	0x02		//   throttle hold, no forward
+#define THM_IDLE	0x04		//   idle-up
+#define THM_NBRAKE	0x08		//   neutral brake, set from model
 
 
 
@@ -108,6 +115,7 @@ extern void apply_model_config(void);
 extern void set_menu_channels_mixed(void);
 extern u8 menu_electronic_trims(void);
 extern u8 menu_buttons(void);
+extern u16 menu_key_time;	// time_ms of press of key calling key function
 extern u8 *menu_et_function_name(u8 n);
 extern s8 menu_et_function_idx(u8 n);
 extern u8 menu_et_function_long_special(u8 n);
@@ -117,6 +125,7 @@ extern u8 *menu_key_function_name(u8 n);
 extern s8 menu_key_function_idx(u8 n);
 extern u8 menu_key_function_2state(u8 n);
 extern u8 menu_key_function_is_allowed(u8 n);
+extern u8 menu_key_function_change(u8 n);
 extern void menu_et_function_set_from_linear(u8 n, s16 val);
 extern const u8 steps_map[];
 #define STEPS_MAP_SIZE  11
@@ -177,7 +186,6 @@ void menu_list(menu_list_t *menu_funcs, u8 menu_nitems, u8 flags);
 
 // timers
 // types
-#define TIMER_NUM	2
 #define TIMER_OFF	0
 #define TIMER_UP	1
 #define TIMER_DOWN	2
@@ -185,26 +193,30 @@ void menu_list(menu_list_t *menu_funcs, u8 menu_nitems, u8 flags);
 #define TIMER_LAPCNT	4
 #define TIMER_TYPE_MAX	4
 
-#define TIMER_TYPE(tid)  ((u8)(tid ? cg.timer2_type : cg.timer1_type))
+#define TIMER_TYPE(tid)  ((u8)menu_timer[tid].cfg->type)
 #define TIMER_TYPE_SET(tid, val) \
-    if (tid) cg.timer2_type = (u8)val; \
-    else cg.timer1_type = (u8)val;
+    menu_timer[tid].cfg->type = (u8)val;
 
-#define TIMER_ALARM(tid)  ((u8)(tid ? cg.timer2_alarm : cg.timer1_alarm))
+#define TIMER_ALARM(tid)  (menu_timer[tid].cfg->alarm)
 #define TIMER_ALARM_SET(tid, val) \
-    if (tid) cg.timer2_alarm = (u8)val; \
-    else cg.timer1_alarm = (u8)val;
+    menu_timer[tid].cfg->alarm = (u8)val;
+
+#define TIMER_SW(tid)  ((u8)menu_timer[tid].cfg->sw)
 
 // menu task will be waked-up periodically to show timer value
 extern _Bool	 menu_timer_wakeup;
 extern u8	 menu_timer_running;		// running timers, one bit for one timer
-extern u8	 menu_timer_direction;		// up(0)/down(1) timer direction
 extern u8	 menu_timer_alarmed;		// down timer was over, one bit for one timer
+extern volatile u8 menu_timer_alarm_new;	// alarms not handled yet
 extern @near u8  menu_timer_throttle;		// throttle start, one bit for one timer
 
+// timer descriptor, timer interrupt counts all timers in one loop over them
 typedef struct {
     u16	sec;					// timer seconds
     u8	hdr;					// timers 0.01 seconds
+    u8	down;					// counting down
+    u16	alarm;					// alarm in seconds (laps)
+    config_timer_s *cfg;			// type and alarm setting
 } menu_timer_s;
 extern @near menu_timer_s menu_timer[];		// actual timer values
 #define TIMER_READ(pt, tsec, thdr) \
@@ -212,12 +224,14 @@ extern @near menu_timer_s menu_timer[];		// actual timer values
     tsec = pt->sec; \
     thdr = pt->hdr; \
     rim();
-extern @near u16 menu_timer_alarm[];		// alarm in seconds
 
+void menu_timer_init(void);
 void menu_timer_show(u8 tid);
 void menu_timer_setup(u8 tid);
 void menu_timer_lap_times(u8 tid);
 void menu_timer_clear(u8 tid, u8 laps);
+void menu_timer_laplog_init(void);
+void menu_timer_laplog_flush(void);
 void kf_menu_timer_start(u8 *id, u8 *param, u8 flags, s16 *pv);
 void kf_menu_timer_reset(u8 *id, u8 *param, u8 flags, s16 *pv);
 
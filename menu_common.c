@@ -21,7 +21,9 @@
 #include <string.h>
 #include "menu.h"
 #include "config.h"
+#include "calc.h"
 #include "ppm.h"
+#include "ppm_in.h"
 #include "input.h"
 #include "lcd.h"
 #include "buzzer.h"
@@ -38,7 +40,7 @@ s8  menu_4WS_mix;		// mix -100..100
 _Bool menu_4WS_crab;		// when 1, crab steering
 s8  menu_DIG_mix;		// mix -100..100
 u8  menu_MP_index[MP_COUNT];	// index of MultiPosition channels
-_Bool menu_brake;		// when 1, full brake is applied
+u8  menu_throttle_mode;		// active throttle overlay modes
 
 
 
@@ -59,6 +61,9 @@ void set_menu_channels_mixed(void) {
 	menu_channels_mixed |= (u8)(1 << (u8)(cm.channel_DIG - 1));
     if (cm.channel_brake)
 	menu_channels_mixed |= (u8)(1 << (u8)(cm.channel_brake - 1));
+    // programmable mixes are added to channel values, they skip channels
+    //   mixed above
+    calc_mix_prepare(menu_channels_mixed);
 }
 
 
@@ -68,8 +73,13 @@ void apply_model_config(void) {
 
     // set number of channels for this model
     ppm_set_channels((u8)(cm.channels + 1));
+    ppm_set_map();
 
     set_menu_channels_mixed();
+    calc_curve_prepare();
+    calc_abs_prepare();
+    calc_throttle_prepare();
+    calc_ppm_in_prepare();
 
     // set autorepeat
     for (i = 0; i < 4; i++) {
@@ -84,6 +94,10 @@ void apply_model_config(void) {
 // load model config from eeprom and set model settings
 void menu_load_model(void) {
     u8 i;
+    // hold actual PPM values, model config is not valid till applied
+    //   and EEPROM reads/writes can let CALC run
+    calc_hold = (u8)(channels ? 1 : 0);
+
     // load config
     config_model_read();
 
@@ -108,13 +122,14 @@ void menu_load_model(void) {
     if (cm.channel_MP3 && cm.channel_MP3 != MP_DIG)
 	menu_channel3_8[cm.channel_MP3 - 3] = cm.multi_position3[0];
 
-    menu_brake = 0;
+    menu_throttle_mode = 0;
 
     // set state of buttons to do initialize
     menu_buttons_initialize();
 
     // apply config to radio setting
     apply_model_config();
+    calc_hold = 0;
 }
 
 
@@ -124,6 +139,8 @@ void apply_global_config(void) {
     backlight_on();
     // compute raw value for battery low voltage
     battery_low_raw = (u16)(((u32)cg.battery_calib * cg.battery_low + 50) / 100);
+    // PPM input capture
+    ppm_in_set(cg.ppm_in);
 }
 
 
@@ -144,7 +161,7 @@ void menu_stop(void) {
 	battery_low_on = 1;
 	lcd_segment(LS_SYM_LOWPWR, LS_ON);
 	lcd_segment_blink(LS_SYM_LOWPWR, LB_SPC);
-	buzzer_on(40, 160, BUZZER_MAX);
+	buzzer_play(buzzer_battery, BUZZER_MAX);
     }
     else {
 	// battery low now OK
@@ -320,12 +320,15 @@ static void gs_hardware(u8 action) {
 		    cg.ppm_length =
 			(u8)(menu_change_val(cg.ppm_length + 3, 3, 18, 1, 0) - 3);
 		break;
+	    case 5:
+		cg.ppm_in ^= 1;
+		break;
 	}
     }
 
     // select next value
     else if (action == MLA_NEXT) {
-	if (++menu_set > 4)  menu_set = 0;
+	if (++menu_set > 5)  menu_set = 0;
     }
 
     // show values
@@ -353,6 +356,10 @@ static void gs_hardware(u8 action) {
 	    lcd_char(LCHR1, 'L');
 	    menu_blink |= MCB_CHR2;	// blink char2 too
 	    break;
+	case 5:
+	    lcd_chars("PI");
+	    lcd_char(LCHR3, (u8)(cg.ppm_in ? 'Y' : 'N'));
+	    break;
     }
 }
 
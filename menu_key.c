@@ -257,6 +257,22 @@ static void km_ch3_pot(u8 action) {
 #define KEY_FUNCTIONS_SIZE  32
 @near static u8 key_functions[KEY_FUNCTIONS_SIZE];
 @near static u8 key_functions_max;
+
+// select next/previous allowed key function, map through key_functions
+//   (used also for logical switches)
+u8 menu_key_function_change(u8 n) {
+    u8 idx = (u8)menu_key_function_idx(n);
+    u8 new_idx;
+
+    while (1) {
+	idx = (u8)menu_change_val(idx, 0, key_functions_max, 1, 1);
+	new_idx = key_functions[idx];
+	if (!new_idx)  continue;				// empty slot
+	new_idx--;	// was one more
+	if (menu_key_function_is_allowed(new_idx))  return new_idx;
+    }
+}
+
 // 7seg:  C b E 1l 1r 2l 2r 3l 3r dl dr
 // chars:
 // function
@@ -272,7 +288,7 @@ static void km_ch3_pot(u8 action) {
 //   other
 static void km_key(u8 action) {
     config_key_map_s *km = &ck.key_map[menu_id - NUM_TRIMS];
-    u8 idx, new_idx = 0;
+    u8 new_idx = 0;
 
     if (action == 1) {
 	// change value
@@ -280,14 +296,7 @@ static void km_key(u8 action) {
 	    case 0:
 		// function
 		// select new function, map through key_functions
-		idx = menu_key_function_idx(km->function);
-		while (1) {
-		    idx = (u8)menu_change_val(idx, 0, key_functions_max, 1, 1);
-		    new_idx = key_functions[idx];
-		    if (!new_idx)  continue;				// empty slot
-		    new_idx--;	// was one more
-		    if (menu_key_function_is_allowed(new_idx))  break;	// we have it
-		}
+		new_idx = menu_key_function_change(km->function);
 		// set values to defaults
 		if (km->momentary)  *(u16 *)km = 0;  // was momentary, zero all
 		else {
@@ -316,14 +325,7 @@ static void km_key(u8 action) {
 	    case 4:
 		// function long
 		// select new function, map through key_functions
-		idx = menu_key_function_idx(km->function_long);
-		while (1) {
-		    idx = (u8)menu_change_val(idx, 0, key_functions_max, 1, 1);
-		    new_idx = key_functions[idx];
-		    if (!new_idx)  continue;				// empty slot
-		    new_idx--;	// was one more
-		    if (menu_key_function_is_allowed(new_idx))  break;	// we have it
-		}
+		new_idx = menu_key_function_change(km->function_long);
 		// set values to defaults
 		km->reverse_long = 0;
 		km->previous_val_long = 0;
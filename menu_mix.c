@@ -24,6 +24,7 @@
 #include "calc.h"
 #include "timer.h"
 #include "ppm.h"
+#include "ppm_in.h"
 #include "lcd.h"
 #include "buzzer.h"
 #include "input.h"
@@ -265,6 +266,358 @@ static void mix_brake_channel(u8 action) {
 
 
 
+// programmable mix lines, they start at menu_id 8
+//   settings: destination channel, source channel, rates for both sides
+//   of source, offset, enable switch channel
+static void mix_line(u8 action) {
+    u8 line = (u8)(menu_id - 8);
+    config_mix_s *m = &cm.mix[line];
+    u8 val;
+    s8 sw;
+
+    if (action == MLA_CHG) {
+	// change value
+	switch (menu_set) {
+	    case 0:
+		// destination channel number/off
+		m->dst = (u8)menu_change_val(m->dst, 0, channels, 1, 1);
+		if (!m->src)  m->src = 1;
+		break;
+	    case 1:
+		// source channel, PPM inputs follow after model channels
+		//   in menu
+		val = m->src;
+		if (val > MAX_CHANNELS)  val = (u8)(val - MAX_CHANNELS + channels);
+		val = (u8)menu_change_val(val, 1, channels + PPM_IN_MIX, 1, 1);
+		if (val > channels)  val = (u8)(val - channels + MAX_CHANNELS);
+		m->src = val;
+		break;
+	    case 2:
+	    case 3:
+		// rate for left/right side of source
+		m->rate[menu_set - 2] = (s8)menu_change_val(m->rate[menu_set - 2],
+							    -100, 100, MIX_FAST, 0);
+		break;
+	    case 4:
+		// offset
+		m->offset = (s8)menu_change_val(m->offset, -100, 100,
+						MIX_FAST, 0);
+		break;
+	    case 5:
+		// enable switch, minus for negative side of channel or
+		//   switched off logical switch, logical switches follow
+		//   after model channels in menu
+		val = (u8)(m->sw < 0 ? -m->sw : m->sw);
+		if (val > MAX_CHANNELS)  val = (u8)(val - MAX_CHANNELS + channels);
+		sw = (s8)menu_change_val(m->sw < 0 ? -val : val,
+					 -(s16)(channels + LSW_NUM),
+					 channels + LSW_NUM, 1, 0);
+		val = (u8)(sw < 0 ? -sw : sw);
+		if (val > channels)  val = (u8)(val - channels + MAX_CHANNELS);
+		m->sw = (s8)(sw < 0 ? -val : val);
+		break;
+	}
+	set_menu_channels_mixed();
+    }
+    else if (action == MLA_NEXT) {
+	// select next value
+	if (++menu_set > 5)  menu_set = 0;
+	if (!m->dst)  menu_set = 0;
+    }
+
+    // show value
+    switch (menu_set) {
+	case 0:
+	    // line number and destination channel/OFF
+	    lcd_7seg(L7_M);
+	    lcd_char(LCHR1, (u8)(line + '1'));
+	    lcd_char(LCHR2, ' ');
+	    lcd_char(LCHR3, (u8)(m->dst + '0'));
+	    lcd_segment(LS_SYM_CHANNEL, LS_ON);
+	    menu_blink &= (u8)~(MCB_CHR1 | MCB_CHR2);
+	    break;
+	case 1:
+	    // source channel or PPM input
+	    lcd_7seg(L7_I);
+	    if (m->src > MAX_CHANNELS) {
+		lcd_char(LCHR1, ' ');
+		lcd_char(LCHR2, 'T');
+		lcd_char(LCHR3, (u8)(m->src - MAX_CHANNELS + '0'));
+	    }
+	    else {
+		lcd_char_num3(m->src);
+		lcd_segment(LS_SYM_CHANNEL, LS_ON);
+	    }
+	    break;
+	case 2:
+	case 3:
+	    // rate with arrow of source side
+	    lcd_7seg(L7_R);
+	    lcd_char_num3(m->rate[menu_set - 2]);
+	    lcd_segment(LS_SYM_PERCENT, LS_ON);
+	    val = (u8)(menu_set == 2 ? LS_SYM_LEFT : LS_SYM_RIGHT);
+	    lcd_segment(val, LS_ON);
+	    break;
+	case 4:
+	    // offset
+	    lcd_7seg(L7_O);
+	    lcd_char_num3(m->offset);
+	    lcd_segment(LS_SYM_PERCENT, LS_ON);
+	    break;
+	case 5:
+	    // enable switch
+	    lcd_7seg(L7_E);
+	    val = (u8)(m->sw < 0 ? -m->sw : m->sw);
+	    if (!m->sw)  lcd_chars("ON ");
+	    else if (val > MAX_CHANNELS) {
+		// logical switch
+		lcd_char(LCHR1, (u8)(m->sw < 0 ? '-' : ' '));
+		lcd_char(LCHR2, 'L');
+		lcd_char(LCHR3, (u8)(val - MAX_CHANNELS + '0'));
+	    }
+	    else {
+		lcd_char_num3(m->sw);
+		lcd_segment(LS_SYM_CHANNEL, LS_ON);
+	    }
+	    break;
+    }
+}
+
+
+
+// steering and throttle curves, they are at menu_id 12 and 13
+//   settings: curve type, then 9 CRV points or ARC break point and value
+static const u8 curve_labels[][3] = {
+    "EX", "CV", "AR"
+};
+static void mix_curve(u8 action) {
+    u8 id = (u8)(menu_id - 12);
+    config_curve_s *c = &cm.curve[id];
+    u8 type = id ? cm.curve_throttle : cm.curve_steering;
+    u8 nset = (u8)(type == CURVE_CRV ? CURVE_POINTS : 2);
+
+    if (action == MLA_CHG) {
+	// change value
+	if (menu_set == 0) {
+	    // curve type
+	    type = (u8)menu_change_val(type, 0, CURVE_ARC, 1, 1);
+	    if (id)  cm.curve_throttle = type;
+	    else     cm.curve_steering = type;
+	}
+	else if (type == CURVE_CRV)
+	    c->point[menu_set - 1] = (s8)menu_change_val(c->point[menu_set - 1],
+							 -100, 100,
+							 CURVE_FAST, 0);
+	else if (menu_set == 1)
+	    c->arc_x = (u8)menu_change_val(c->arc_x, 10, 90, CURVE_FAST, 0);
+	else
+	    c->arc_y = (u8)menu_change_val(c->arc_y, 0, 100, CURVE_FAST, 0);
+	calc_curve_prepare();
+    }
+    else if (action == MLA_NEXT) {
+	// select next value, no values for expo
+	if (++menu_set > nset || type == CURVE_EXP)  menu_set = 0;
+    }
+
+    // show value
+    if (menu_set == 0) {
+	// channel and curve type
+	lcd_7seg(L7_C);
+	lcd_char(LCHR1, (u8)(id + '1'));
+	lcd_chars2(curve_labels[type]);
+	lcd_segment(LS_SYM_CHANNEL, LS_ON);
+	menu_blink &= (u8)~MCB_CHR1;
+    }
+    else {
+	// point number and its value
+	lcd_7seg(menu_set);
+	if (type == CURVE_CRV)	  lcd_char_num3(c->point[menu_set - 1]);
+	else if (menu_set == 1)	  lcd_char_num3(c->arc_x);
+	else			  lcd_char_num3(c->arc_y);
+	lcd_segment(LS_SYM_PERCENT, LS_ON);
+    }
+}
+
+
+
+// logical switches, they are at menu_id 14..17
+//   settings: function, first parameter (channel/key/timer/switch),
+//   value or second switch, invert, key function switched by it
+static const u8 lsw_labels[][3] = {
+    "--", "GT", "LT", "KY", "TM", "AN", "OR"
+};
+static void mix_switch(u8 action) {
+    u8 id = (u8)(menu_id - 14);
+    config_lsw_s *l = &cm.lsw[id];
+    u8 func = l->func;
+
+    if (action == MLA_CHG) {
+	// change value
+	switch (menu_set) {
+	    case 0:
+		// function, set valid parameters
+		l->func = func = (u8)menu_change_val(func, 0, LSW_FUNC_MAX,
+						     1, 1);
+		l->a = (u8)(func == LSW_GT || func == LSW_LT);
+		l->b = 0;
+		l->inv = 0;
+		break;
+	    case 1:
+		// channel, key, timer or switch
+		if (func == LSW_KEY)
+		    l->a = (u8)menu_change_val(l->a, 0, 12, 1, 1);
+		else if (func == LSW_TIMER)
+		    l->a = (u8)menu_change_val(l->a, 0, TIMER_NUM - 1, 1, 1);
+		else if (func >= LSW_AND)
+		    l->a = (u8)menu_change_val(l->a, 0, LSW_NUM - 1, 1, 1);
+		else
+		    l->a = (u8)menu_change_val(l->a, 1, channels, 1, 1);
+		break;
+	    case 2:
+		// value or second switch
+		if (func >= LSW_AND)
+		    l->b = (u8)menu_change_val(l->b, 0, LSW_NUM - 1, 1, 1);
+		else
+		    l->val = (s8)menu_change_val(l->val, -100, 100,
+						 CHANNEL_FAST, 0);
+		break;
+	    case 3:
+		// invert
+		l->inv ^= 1;
+		break;
+	    case 4:
+		// key function
+		l->kf = menu_key_function_change(l->kf);
+		break;
+	}
+    }
+    else if (action == MLA_NEXT) {
+	// select next value, skip value for key and timer
+	if (++menu_set == 2 && (func == LSW_KEY || func == LSW_TIMER))
+	    menu_set = 3;
+	if (menu_set > 4 || func == LSW_OFF)  menu_set = 0;
+    }
+
+    // show value
+    switch (menu_set) {
+	case 0:
+	    // switch number and function
+	    lcd_7seg(L7_L);
+	    lcd_char(LCHR1, (u8)(id + '1'));
+	    lcd_chars2(lsw_labels[func]);
+	    menu_blink &= (u8)~MCB_CHR1;
+	    break;
+	case 1:
+	    // first parameter, switches are shown from 1
+	    lcd_7seg(L7_A);
+	    if (func == LSW_GT || func == LSW_LT) {
+		lcd_char_num3(l->a);
+		lcd_segment(LS_SYM_CHANNEL, LS_ON);
+	    }
+	    else  lcd_char_num3(l->a + 1);
+	    break;
+	case 2:
+	    // value or second switch
+	    lcd_7seg(L7_B);
+	    if (func >= LSW_AND)  lcd_char_num3(l->b + 1);
+	    else {
+		lcd_char_num3(l->val);
+		lcd_segment(LS_SYM_PERCENT, LS_ON);
+	    }
+	    break;
+	case 3:
+	    // invert
+	    lcd_7seg(L7_I);
+	    lcd_chars(l->inv ? "REV" : "NOR");
+	    break;
+	case 4:
+	    // key function
+	    lcd_7seg(L7_F);
+	    lcd_chars(menu_key_function_name(l->kf));
+	    break;
+    }
+}
+
+
+
+
+// PPM input mapped to output channels, it is at menu_id 18
+//   menu_set is output channel, value is PPM input number or OFF
+static void mix_ppm_in(u8 action) {
+    u8 *addr = &cm.ppm_in_map[menu_set >> 1];
+    u8 shift = (u8)((menu_set & 1) << 2);
+    u8 val = (u8)((*addr >> shift) & 0x0f);
+
+    if (action == MLA_CHG) {
+	val = (u8)menu_change_val(val, 0, PPM_IN_CHANNELS, 1, 1);
+	*addr = (u8)((*addr & (u8)~(0x0f << shift)) | (val << shift));
+    }
+    else if (action == MLA_NEXT) {
+	// select next output channel
+	if (++menu_set >= channels)  menu_set = 0;
+	addr = &cm.ppm_in_map[menu_set >> 1];
+	shift = (u8)((menu_set & 1) << 2);
+	val = (u8)((*addr >> shift) & 0x0f);
+    }
+
+    // show output channel and input
+    lcd_7seg(L7_T);
+    lcd_char(LCHR1, (u8)(menu_set + '1'));
+    lcd_char(LCHR2, ' ');
+    lcd_char(LCHR3, (u8)(val ? val + '0' : '-'));
+    lcd_segment(LS_SYM_CHANNEL, LS_ON);
+    menu_blink &= (u8)~(MCB_CHR1 | MCB_CHR2);
+}
+
+
+
+
+// output positions of channels, it is at menu_id 19
+//   menu_set is channel, value is its output position, changing it
+//   swaps position with channel at new position
+static u8 ppm_out_get(u8 ch) {
+    u8 pos = (u8)((cm.ppm_out_map[ch >> 1] >> ((ch & 1) << 2)) & 0x0f);
+    return (u8)(pos ? pos : ch + 1);
+}
+static void ppm_out_put(u8 ch, u8 pos) {
+    u8 *addr = &cm.ppm_out_map[ch >> 1];
+    u8 shift = (u8)((ch & 1) << 2);
+    if (pos == ch + 1)  pos = 0;	// the same position is default
+    *addr = (u8)((*addr & (u8)~(0x0f << shift)) | (pos << shift));
+}
+static void mix_ppm_out(u8 action) {
+    u8 pos = ppm_out_get(menu_set);
+    u8 i, old;
+
+    if (action == MLA_CHG) {
+	old = pos;
+	pos = (u8)menu_change_val(pos, 1, channels, 1, 1);
+	// swap with channel which was at new position
+	for (i = 0; i < channels; i++) {
+	    if (ppm_out_get(i) != pos)  continue;
+	    ppm_out_put(i, old);
+	    break;
+	}
+	ppm_out_put(menu_set, pos);
+	ppm_set_map();
+    }
+    else if (action == MLA_NEXT) {
+	// select next channel
+	if (++menu_set >= channels)  menu_set = 0;
+	pos = ppm_out_get(menu_set);
+    }
+
+    // show channel and its output position
+    lcd_7seg(L7_O);
+    lcd_char(LCHR1, (u8)(menu_set + '1'));
+    lcd_char(LCHR2, ' ');
+    lcd_char(LCHR3, (u8)(pos + '0'));
+    lcd_segment(LS_SYM_CHANNEL, LS_ON);
+    menu_blink &= (u8)~(MCB_CHR1 | MCB_CHR2);
+}
+
+
+
 
 static const menu_list_t mix_funcs[] = {
     mix_4WS,
@@ -275,6 +628,18 @@ static const menu_list_t mix_funcs[] = {
     mix_MultiPosition,
     mix_brake_off,
     mix_brake_channel,
+    mix_line,
+    mix_line,
+    mix_line,
+    mix_line,
+    mix_curve,
+    mix_curve,
+    mix_switch,
+    mix_switch,
+    mix_switch,
+    mix_switch,
+    mix_ppm_in,
+    mix_ppm_out,
 };
 
 
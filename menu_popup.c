@@ -46,9 +46,15 @@ static @near u8 menu_buttons_state[NUM_KEYS + 2 * NUM_TRIMS];
 #define MBS_ON		0x40
 #define MBS_ON_LONG	0x80
 
+// last state of logical switches with key functions, switches
+//   in lsw_initialize will set their 2-state functions at first check
+static u8 lsw_state;
+static u8 lsw_initialize;
+
 // set state of buttons to do initialize
 void menu_buttons_initialize(void) {
     memset(menu_buttons_state, MBS_INITIALIZE, sizeof(menu_buttons_state));
+    lsw_initialize = 0xff;
     menu_check_keys = 1;
 }
 
@@ -57,6 +63,7 @@ void menu_buttons_initialize(void) {
 // previous values for using buttons that way to return to previous value
 //   instead of centre/left
 static @near s16 menu_buttons_previous_values[NUM_KEYS + 2 * NUM_TRIMS];
+static @near s16 lsw_previous_values[LSW_NUM];
 
 
 #define BEEP_RESET  if (cg.reset_beep)  buzzer_on(20, 0, 1)
@@ -773,16 +780,18 @@ static void kf_battery_low_shutup(u8 *id, u8 *param, u8 flags, s16 *pv) {
     buzzer_off();
 }
 
-// change menu_brake bit
-static void kf_brake(u8 *id, u8 *param, u8 flags, s16 *prev_val) {
-    if (flags & FF_ON)
-	menu_brake = (u8)(flags & FF_REVERSE ? 0 : 1);
-    else
-	menu_brake = (u8)(flags & FF_REVERSE ? 1 : 0);
+// change throttle mode bit given in param
+static void kf_throttle_mode(u8 *id, u8 *param, u8 flags, s16 *prev_val) {
+    u8 bit = (u8)(u16)param;
+    u8 on = (u8)(flags & FF_ON ? 1 : 0);
+
+    if (flags & FF_REVERSE)  on ^= 1;
+    if (on)  menu_throttle_mode |= bit;
+    else     menu_throttle_mode &= (u8)~bit;
 
     if (flags & FF_SHOW) {
-	lcd_7seg(L7_B);
-	lcd_chars(menu_brake ? "BRK" : "OFF");
+	lcd_7seg(2);
+	lcd_chars(on ? id : (u8 *)"OFF");
     }
 }
 
@@ -792,7 +801,7 @@ static void kf_brake(u8 *id, u8 *param, u8 flags, s16 *prev_val) {
 // table of key functions
 static const key_functions_s key_functions[] = {
     { 0, "OFF", KF_NONE, NULL, NULL, 0 },
-    { 29, "BLS", KF_NOSHOW, kf_battery_low_shutup, NULL, 0 },  // default END-long
+    { 31, "BLS", KF_NOSHOW, kf_battery_low_shutup, NULL, 0 },  // default END-long
     { 1, "CH3", KF_2STATE, kf_set_switch, NULL, 3 },
     { 7, "C3R", KF_NONE, kf_reset, "CH3", 3 },
 #if MAX_CHANNELS >= 4
@@ -830,7 +839,9 @@ static const key_functions_s key_functions[] = {
     { 25, "T1R", KF_NOSHOW, kf_menu_timer_reset, (u8 *)0, 0 },
     { 26, "T2S", KF_NOSHOW, kf_menu_timer_start, (u8 *)1, 0 },
     { 27, "T2R", KF_NOSHOW, kf_menu_timer_reset, (u8 *)1, 0 },
-    { 28, "BRK", KF_2STATE, kf_brake, NULL, 0 },
+    { 28, "BRK", KF_2STATE, kf_throttle_mode, (u8 *)THM_BRAKE, 0 },
+    { 29, "HLD", KF_2STATE, kf_throttle_mode, (u8 *)THM_HOLD, 0 },
+    { 30, "IDL", KF_2STATE, kf_throttle_mode, (u8 *)THM_IDLE, 0 },
     // beware of BLS with last id
 };
 #define KEY_FUNCTIONS_SIZE  (sizeof(key_functions) / sizeof(key_functions_s))
@@ -874,6 +885,7 @@ static void menu_key_empty_id(void) {
 
 // change val, temporary show new value (not always)
 // end when another key pressed
+u16 menu_key_time;
 static u8 menu_popup_key(u8 key_id) {
     u16 delay_time;
     u16 buttons_state_last;
@@ -892,6 +904,7 @@ static u8 menu_popup_key(u8 key_id) {
     // prepare more variables
     kf = &key_functions[km->function];
     btnx = key_buttons[key_id];
+    menu_key_time = button_time(btnx);
 
     // remember buttons state
     buttons_state_last = buttons_state & ~btnx;
@@ -1092,11 +1105,39 @@ static u8 menu_popup_key(u8 key_id) {
 
 
 
+// switch key functions of changed logical switches, 2-state functions
+//   follow switch state, other functions are called when switch turns on
+static void menu_switches(void) {
+    u8 sw = calc_switches;
+    u8 changed = (u8)((sw ^ lsw_state) | lsw_initialize);
+    config_lsw_s *l = cm.lsw;
+    key_functions_s *kf;
+    u8 i, bit;
+
+    if (!changed)  return;
+    menu_key_time = (u16)time_ms;	// for lap timer started by switch
+    for (i = 0, bit = 1; i < LSW_NUM; i++, l++, bit <<= 1) {
+	if (!(changed & bit) || !l->kf)  continue;
+	kf = &key_functions[l->kf];
+	if (kf->flags & KF_2STATE)
+	    kf->func(kf->name, kf->param, (u8)(sw & bit ? FF_ON : FF_NONE),
+		     &lsw_previous_values[i]);
+	else if ((sw & bit) && !(lsw_initialize & bit))
+	    kf->func(kf->name, kf->param, FF_NONE, &lsw_previous_values[i]);
+    }
+    lsw_state = sw;
+    lsw_initialize = 0;
+}
+
+
 // check buttons CH3, BACK, END, invoke popup to show value
 // return 1 when popup was activated
 u8 menu_buttons(void) {
     u8 i;
 
+    // key functions switched by logical switches
+    menu_switches();
+
     // for each key, call function
     for (i = 0; i < KEY_BUTTONS_SIZE; i++) {
 	if (i >= NUM_KEYS && ck.key_map[i].is_trim)
@@ -35,20 +35,68 @@ _Bool menu_timer_wakeup;
 
 // actual timer values
 u8        menu_timer_running;		// running timers
-u8	  menu_timer_direction;		// up(0)/down(1) timer direction
 u8	  menu_timer_alarmed;		// down timer was over, one bit for one timer
+volatile u8 menu_timer_alarm_new;	// alarms from timer interrupt not handled yet
 @near u8  menu_timer_throttle;		// throttle start for each timer
 @near menu_timer_s menu_timer[TIMER_NUM];	// actual timer values
-@near u16 menu_timer_alarm[TIMER_NUM];		// alarm in seconds
 // number of laps
 #define TIMER_MAX_LAPCNT 255
 static @near u8  timer_lap_count[TIMER_NUM];
-// time for each lap
-#define TIMER_MAX_LAPS 100
-static @near menu_timer_s timer_lap_time[TIMER_NUM][TIMER_MAX_LAPS];
+// lap times in 0.01s are stored as stream of nibbles (3 bits of value
+//   in each nibble, bit 3 set when next nibble follows), each
+//   TIMER_LAP_CHK-th lap is stored as full value at byte boundary and its
+//   byte offset is in timer_lap_chk for quick access, other laps are
+//   stored as zigzag-encoded difference to average of laps from last full
+//   value, so usual laps (up to 2.5s from average) take 1-1.5 bytes and
+//   about 150 laps fit
+// when stream is full, next laps are only counted
+#define TIMER_LAP_BYTES	224
+#define TIMER_MAX_LAPS	240
+#define TIMER_LAP_CHK	16
+static @near u8  timer_lap_data[TIMER_NUM][TIMER_LAP_BYTES];
+static @near u8  timer_lap_chk[TIMER_NUM][(TIMER_MAX_LAPS + TIMER_LAP_CHK - 1)
+					  / TIMER_LAP_CHK];
+static @near u16 timer_lap_len[TIMER_NUM];	// used nibbles of stream
+static @near u32 timer_lap_sum[TIMER_NUM];	// laps from last full value
+static @near u8  timer_lap_num[TIMER_NUM];	// laps in stream
+static @near u32 timer_lap_last[TIMER_NUM];	// last lap time
+static @near u32 timer_lap_total[TIMER_NUM];	// timer value at last lap
+static @near u32 timer_lap_done[TIMER_NUM];	// laps before timer reset
+							//   or restored laps
+// lap statistics updated at each lap, times in 0.01s limited to u16
+#define TIMER_STAT_LAPS	5
+typedef struct {
+    u16 ring[TIMER_STAT_LAPS];	// last laps
+    u8  ring_pos;		// next position in ring
+    u8  ring_cnt;		// number of laps in ring
+    u16 best;			// best lap, 0 when no lap yet
+    u16 avg;			// average of last laps
+    u16 dev;			// standard deviation of last laps
+    s16 delta;			// last lap minus best lap before it
+} timer_stat_s;
+static @near timer_stat_s timer_stat[TIMER_NUM];
 // time when lap button can be pressed (to eliminate double-clicks)
 static @near u16 next_timer_sec[TIMER_NUM];
 static @near u16 next_timer_sec_display[TIMER_NUM];
+// lap log at EEPROM, ring of lap times with sequence numbers, newest entry
+//   is before break of sequence, each entry is rewritten only once
+//   per LAPLOG_ENTRIES laps, so there is no often written place
+// laps are queued and written from INPUT task without waiting for EEPROM
+// each timer has its session number, new session starts at first lap
+//   after clearing laps, laps of last session are restored at power-on
+#define LAPLOG_ENTRIES	(u8)(EEPROM_LAPLOG_SIZE / sizeof(laplog_entry_s))
+#define LAPLOG_QUEUE	4
+#define LAPLOG_SESSION	0x7f
+#define laplog_entry(idx)	((laplog_entry_s *)EEPROM_LAPLOG + (idx))
+#define laplog_next(idx)	(u8)((idx) < LAPLOG_ENTRIES - 1 ? (idx) + 1 : 0)
+#define laplog_seq_next(seq)	(u8)((seq) == 255 ? 1 : (seq) + 1)
+static u8 laplog_pos;		// position of next entry
+static u8 laplog_seq;		// sequence number of next entry
+static u8 laplog_new;		// start new session, one bit for one timer
+static @near u8 laplog_session[TIMER_NUM];	// actual session of timers
+static @near laplog_entry_s laplog_queue[LAPLOG_QUEUE];	// not written yet
+static u8 laplog_queue_pos;	// first queued entry
+static u8 laplog_queue_cnt;	// number of queued entries
 
 
 
@@ -96,6 +144,26 @@ static void timer_value(menu_timer_s *pt) {
 }
 
 
+// show timer value given in 0.01s
+static void timer_value_hdr(u32 t) {
+    menu_timer_s tm;
+    tm.sec = (u16)(t / 100);
+    tm.hdr = (u8)(t % 100);
+    timer_value(&tm);
+}
+
+
+// show lap time difference in 0.1s with "d" at 7seg
+static void timer_delta(s16 delta) {
+    delta = (s16)((delta + (delta < 0 ? -5 : 5)) / 10);
+    if (delta < -199)  delta = -199;
+    else if (delta > 999)  delta = 999;
+    lcd_7seg(L7_D);
+    lcd_segment(LS_SYM_DOT, LS_ON);
+    lcd_char_num3(delta);
+}
+
+
 // show timer ID as left and right arrow
 static void timer_show_id(u8 tid) {
     if (tid)  lcd_segment(LS_SYM_RIGHT, LS_ON); \
@@ -109,7 +177,6 @@ void menu_timer_show(u8 tid) {
     menu_timer_s *pt = &menu_timer[tid];
     u8 type = TIMER_TYPE(tid);
     u8 tbit = (u8)(1 << tid);
-    u8 lap;
 
     menu_clear_symbols();
     timer_show_id(tid);
@@ -140,31 +207,13 @@ void menu_timer_show(u8 tid) {
 		timer_value(pt);
 		break;
 	    }
-	    // show last lap time for several seconds
-	    lap = timer_lap_count[tid];
-	    if (lap > 1) {
-		menu_timer_s *pt2, tm;
-		s16 hdr;
-		// to last lap id
-		lap--;  // to last lap id
-		while (lap >= TIMER_MAX_LAPS)  lap -= TIMER_MAX_LAPS;
-		timer_value(&timer_lap_time[tid][lap]);
-		// calculate lap time as difference between lap and lap -1
-		if (lap) pt2 = &timer_lap_time[tid][lap - 1];
-		else     pt2 = &timer_lap_time[tid][TIMER_MAX_LAPS - 1];
-		pt = &timer_lap_time[tid][lap];
-		tm.sec = pt->sec - pt2->sec;
-		hdr = pt->hdr - pt2->hdr;
-		if (hdr < 0) {
-		    tm.sec--;
-		    hdr += 100;
-		}
-		tm.hdr = (u8)hdr;
-		timer_value(&tm);
-	    }
-	    else if (lap)
-		// first lap
-		timer_value(&timer_lap_time[tid][0]);
+	    // show last lap time for several seconds, at last second
+	    //   difference to best lap
+	    if (timer_lap_count[tid] > 1
+		&& next_timer_sec_display[tid] - time_sec == 1)
+		timer_delta(timer_stat[tid].delta);
+	    else if (timer_lap_count[tid])
+		timer_value_hdr(timer_lap_last[tid]);
 	    else
 		// no lap
 		timer_value(NULL);
@@ -200,27 +249,44 @@ void menu_timer_clear(u8 tid, u8 laps) {
     // zero values, laps only when requested
     pt->hdr = 0;
     menu_timer_alarmed &= (u8)~tbit;
+    timer_lap_done[tid] += timer_lap_total[tid];
+    timer_lap_total[tid] = 0;
     if (laps == 1 || (laps == 2 && type != TIMER_DOWN)) {
+	timer_lap_done[tid] = 0;
 	timer_lap_count[tid] = 0;
-	memset(&timer_lap_time[tid], 0, TIMER_MAX_LAPS * sizeof(menu_timer_s));
+	timer_lap_num[tid] = 0;
+	timer_lap_len[tid] = 0;
+	timer_lap_last[tid] = 0;
+	memset(&timer_stat[tid], 0, sizeof(timer_stat_s));
+	laplog_new |= tbit;
     }
 
     // set alarm
     if (type == TIMER_LAPCNT)
-	menu_timer_alarm[tid] = TIMER_ALARM(tid);
-    else menu_timer_alarm[tid] = TIMER_ALARM(tid) * 60;
+	pt->alarm = TIMER_ALARM(tid);
+    else pt->alarm = TIMER_ALARM(tid) * 60;
 
     // set direction and seconds
     if (type == TIMER_DOWN) {
 	// down timer
-	pt->sec = menu_timer_alarm[tid];
+	pt->sec = pt->alarm;
 	if (!pt->sec)  pt->sec = 1;	// at least 1 second alarm time
-	menu_timer_direction |= tbit;
+	pt->down = 1;
     }
     else {
 	// up timer
 	pt->sec = 0;
-	menu_timer_direction &= (u8)~tbit;
+	pt->down = 0;
+    }
+}
+
+
+// connect timers to their global config and clear them
+void menu_timer_init(void) {
+    u8 tid;
+    for (tid = 0; tid < TIMER_NUM; tid++) {
+	menu_timer[tid].cfg = &cg.timer[tid];
+	menu_timer_clear(tid, 1);
     }
 }
 
@@ -253,8 +319,8 @@ static void timer_setup_alarm(u8 action) {
 	TIMER_ALARM_SET(timer_id, val);
 	// set value to global var as lap counts or as minutes
 	if (TIMER_TYPE(timer_id) == TIMER_LAPCNT)
-	    menu_timer_alarm[timer_id] = val;
-	else menu_timer_alarm[timer_id] = val * 60;
+	    menu_timer[timer_id].alarm = val;
+	else menu_timer[timer_id].alarm = val * 60;
     }
 
     // select next value
@@ -266,6 +332,26 @@ static void timer_setup_alarm(u8 action) {
     timer_show_id(timer_id);
 }
 
+static void timer_setup_switch(u8 action) {
+    u8 tid = timer_id;	// compiler hack
+    u8 val = TIMER_SW(tid);
+
+    // change value
+    if (action == MLA_CHG) {
+	val = (u8)menu_change_val(val, 0, LSW_NUM, 1, 1);
+	menu_timer[tid].cfg->sw = val;
+    }
+
+    // select next value
+    else if (action == MLA_NEXT)  menu_timer_clear(timer_id, 2);
+
+    // show value, timer runs while logical switch is on
+    lcd_7seg(L7_L);
+    if (val)  lcd_char_num3(val);
+    else      lcd_chars("OFF");
+    timer_show_id(timer_id);
+}
+
 static const u8 timer_type_labels[][4] = {
     "OFF", "UP ", "DWN", "LAP", "LPC"
 };
@@ -291,6 +377,7 @@ static void timer_setup_type(u8 action) {
 static const menu_list_t timer_setup_funcs[] = {
     timer_setup_throttle,
     timer_setup_alarm,
+    timer_setup_switch,
     timer_setup_type,
 };
 
@@ -308,6 +395,46 @@ void menu_timer_setup(u8 tid) {
 
 
 
+// read varint from lap stream, pos is in nibbles
+static u32 timer_lap_varint(u8 *data, u16 *ppos) {
+    u16 pos = *ppos;
+    u32 v = 0;
+    u8 shift = 0;
+    u8 b;
+    do {
+	b = data[pos >> 1];
+	if (pos & 1)  b >>= 4;
+	pos++;
+	v |= (u32)(b & 0x07) << shift;
+	shift += 3;
+    } while (b & 0x08);
+    *ppos = pos;
+    return v;
+}
+
+
+// average of n laps from last full value, used as predicted lap time
+#define timer_lap_avg(sum, n)  (((sum) + (n) / 2) / (n))
+
+
+// read lap time from lap stream, start at nearest full value
+static u32 timer_lap_get(u8 tid, u8 lap) {
+    u8 *data = timer_lap_data[tid];
+    u16 pos = (u16)(timer_lap_chk[tid][lap / TIMER_LAP_CHK] << 1);
+    u8 n = (u8)(lap % TIMER_LAP_CHK);
+    u8 i;
+    u32 t = timer_lap_varint(data, &pos);
+    u32 sum = t;
+    u32 d;
+    for (i = 1; i <= n; i++) {
+	d = timer_lap_varint(data, &pos);
+	t = timer_lap_avg(sum, i) + ((d >> 1) ^ (u32)-(s32)(d & 1));
+	sum += t;
+    }
+    return t;
+}
+
+
 // show timer lap times
 //   menu_id:
 //   	0       first lap
@@ -316,15 +443,19 @@ void menu_timer_setup(u8 tid) {
 //   	nlap    RES reset and end menu, after last lap
 //   	nlap+1  AVG average time
 //   	nlap+2  TOT total time
+//   	nlap+3  BST best lap
+//   	nlap+4  RAV rolling average of last laps
+//   	nlap+5  CNS consistency (standard deviation of last laps)
+// nlap is number of stored laps, AVG and TOT are from all laps
+#define LAP_ITEMS  5
+static const u8 lap_items_7seg[LAP_ITEMS] = {
+    L7_A, L7_T, L7_B, L7_R, L7_C
+};
 static void lap_times_func(u8 action, u8 *ptid) {
     u8 tid = *ptid;
-    u8 laps = timer_lap_count[tid];
-    menu_timer_s *pt, tm;
+    u8 laps = timer_lap_num[tid];
     u8 type = TIMER_TYPE(tid);
 
-    // max 100 laps
-    if (laps > TIMER_MAX_LAPS)  laps = TIMER_MAX_LAPS;
-
     switch (action) {
 	case MCA_INIT:
 	    // to TOTal item when not down timer
@@ -332,9 +463,10 @@ static void lap_times_func(u8 action, u8 *ptid) {
 	    break;
 	case MCA_SET_CHG:
 	case MCA_ID_CHG:
-	    // change to other lap, skip TOT ang AVG for down timer
+	    // change to other lap, skip TOT, AVG, ... for down timer
 	    menu_id = (u8)menu_change_val(menu_id, 0,
-		      laps + (type != TIMER_DOWN ? 2 : 0), LAP_SHOW_FAST, 1);
+		      laps + (type != TIMER_DOWN ? LAP_ITEMS : 0),
+		      LAP_SHOW_FAST, 1);
 	    break;
 	case MCA_SWITCH:
 	    // switch between lap numbers and times
@@ -362,15 +494,10 @@ static void lap_times_func(u8 action, u8 *ptid) {
 	if (menu_id == laps)
 	    lcd_chars("RES");
 	else if (menu_id > laps) {
-	    u8 laps10 = (u8)(laps / 10);
-	    // show ID Average/Total
-	    if (menu_id == laps + 1)  lcd_char(LCHR1, 'A');  // average
-	    else                      lcd_char(LCHR1, 'T');  // total
-	    // show number of laps
-	    if (laps10 == 10)      lcd_char(LCHR2, LCHAR_ONE_ZERO);
-	    else if (laps10 == 0)  lcd_char(LCHR2, ' ');
-	    else                   lcd_char(LCHR2, (u8)(laps10 + '0'));
-	    lcd_char(LCHR3, (u8)(laps % 10 + '0'));
+	    // show ID of Average/Total/... and number of laps
+	    lcd_7seg(lap_items_7seg[menu_id - laps - 1]);
+	    lcd_char_num3(menu_id > laps + 3 ? timer_stat[tid].ring_cnt
+					     : timer_lap_count[tid]);
 	}
 	else lcd_char_num3(menu_id + 1);
 	return;
@@ -384,56 +511,23 @@ static void lap_times_func(u8 action, u8 *ptid) {
 	return;
     }
     else if (menu_id == laps + 1) {
-	// average lap times
-	if (laps) {
-	    // we have at least one lap
-	    u32 tot;
-	    pt = &timer_lap_time[tid][laps - 1];
-	    // count in hundredths
-	    tot = (u32)pt->sec * 100 + pt->hdr;
-	    // average
-	    tot = (tot + laps / 2) / laps;
-	    // assign to timer val
-	    tm.sec = (u16)(tot / 100);
-	    tm.hdr = (u8)(tot % 100);
-	}
-	else {
-	    // no laps, show zero
-	    tm.sec = 0;
-	    tm.hdr = 0;
-	}
-	pt = &tm;
+	// average lap times, zero when no laps
+	u8 cnt = timer_lap_count[tid];
+	timer_value_hdr(cnt ? (timer_lap_done[tid] + timer_lap_total[tid]
+			       + cnt / 2) / cnt : 0);
     }
     else if (menu_id == laps + 2)
-	// total, read time of last lap
-	if (laps) pt = &timer_lap_time[tid][laps - 1];
-	else {
-	    // no laps, show zero
-	    tm.sec = 0;
-	    tm.hdr = 0;
-	    pt = &tm;
-	}
-    else {
+	// total, laps before timer reset and timer value at last lap
+	timer_value_hdr(timer_lap_done[tid] + timer_lap_total[tid]);
+    else if (menu_id == laps + 3)
+	timer_value_hdr(timer_stat[tid].best);
+    else if (menu_id == laps + 4)
+	timer_value_hdr(timer_stat[tid].avg);
+    else if (menu_id == laps + 5)
+	timer_value_hdr(timer_stat[tid].dev);
+    else
 	// show lap time
-	if (menu_id == 0 || type == TIMER_DOWN)
-	    // first lap or down timer
-	    pt = &timer_lap_time[tid][menu_id];
-	else {
-	    // calculate lap time as difference between lap and lap -1
-	    menu_timer_s *pt2 = &timer_lap_time[tid][menu_id - 1];
-	    s16 hdr;
-	    pt = &timer_lap_time[tid][menu_id];
-	    tm.sec = pt->sec - pt2->sec;
-	    hdr = pt->hdr - pt2->hdr;
-	    if (hdr < 0) {
-		tm.sec--;
-		hdr += 100;
-	    }
-	    tm.hdr = (u8)hdr;
-	    pt = &tm;
-	}
-    }
-    timer_value(pt);
+	timer_value_hdr(timer_lap_get(tid, menu_id));
 }
 
 void menu_timer_lap_times(u8 tid) {
@@ -461,31 +555,266 @@ void menu_timer_lap_times(u8 tid) {
 
 
 
+// add lap time to lap stream, if there is space for it
+static void timer_lap_put(u8 tid, u32 t) {
+    u8 n = timer_lap_num[tid];
+    u8 k = (u8)(n % TIMER_LAP_CHK);
+    u8 *data = timer_lap_data[tid];
+    u16 pos = timer_lap_len[tid];
+    u32 v, w;
+    s32 d;
+    u8 cnt, b;
+
+    if (n == TIMER_MAX_LAPS)  return;
+
+    if (!k) {
+	// full value at byte boundary
+	pos = (u16)((pos + 1) & ~1);
+	v = t;
+    }
+    else {
+	// zigzag-encoded difference to average of previous laps
+	d = (s32)(t - timer_lap_avg(timer_lap_sum[tid], k));
+	v = ((u32)d << 1) ^ (u32)(d >> 31);
+    }
+
+    // check space, when full, do not store any next lap
+    cnt = 1;
+    for (w = v >> 3; w; w >>= 3)  cnt++;
+    if (pos + cnt > TIMER_LAP_BYTES * 2) {
+	timer_lap_len[tid] = TIMER_LAP_BYTES * 2;
+	return;
+    }
+
+    if (!k) {
+	timer_lap_chk[tid][n / TIMER_LAP_CHK] = (u8)(pos >> 1);
+	timer_lap_sum[tid] = t;
+    }
+    else  timer_lap_sum[tid] += t;
+    do {
+	b = (u8)(v & 0x07);
+	v >>= 3;
+	if (v)  b |= 0x08;
+	if (pos & 1)  data[pos >> 1] |= (u8)(b << 4);
+	else          data[pos >> 1] = b;
+	pos++;
+    } while (v);
+
+    timer_lap_len[tid] = pos;
+    timer_lap_num[tid]++;
+}
+
+
+// integer square root
+static u16 isqrt(u32 x) {
+    u32 r = 0;
+    u32 bit = (u32)1 << 30;
+    while (bit > x)  bit >>= 2;
+    while (bit) {
+	if (x >= r + bit) {
+	    x -= r + bit;
+	    r = (r >> 1) + bit;
+	}
+	else  r >>= 1;
+	bit >>= 2;
+    }
+    return (u16)r;
+}
+
+
+// update lap statistics with new lap time
+static void timer_stat_add(u8 tid, u32 t) {
+    timer_stat_s *st = &timer_stat[tid];
+    u16 lap = (u16)(t > 0xffff ? 0xffff : t);
+    u8 i;
+    u32 sum = 0;
+    s32 d;
+
+    // difference to best lap and new best lap
+    d = (s32)lap - st->best;
+    st->delta = (s16)(d > 0x7fff ? 0x7fff : d);
+    if (!st->best || lap < st->best)  st->best = lap;
+
+    // ring of last laps
+    st->ring[st->ring_pos] = lap;
+    if (++st->ring_pos == TIMER_STAT_LAPS)  st->ring_pos = 0;
+    if (st->ring_cnt < TIMER_STAT_LAPS)  st->ring_cnt++;
+
+    // average and standard deviation of laps in ring
+    for (i = 0; i < st->ring_cnt; i++)  sum += st->ring[i];
+    st->avg = (u16)((sum + st->ring_cnt / 2) / st->ring_cnt);
+    sum = 0;
+    for (i = 0; i < st->ring_cnt; i++) {
+	d = (s32)st->ring[i] - st->avg;
+	if (d < 0)  d = -d;
+	if (d > 20000)  d = 20000;	// to not overflow sum
+	sum += (u32)d * (u32)d;
+    }
+    st->dev = isqrt(sum / st->ring_cnt);
+}
+
+
+// add lap time to lap times and statistics
+static void timer_lap_add(u8 tid, u32 t) {
+    timer_lap_put(tid, t);
+    timer_lap_last[tid] = t;
+    timer_stat_add(tid, t);
+    timer_lap_count[tid]++;
+}
+
+
+// queue lap time to lap log
+static void laplog_append(u8 tid, u32 t) {
+    laplog_entry_s *e;
+    u8 tbit = (u8)(1 << tid);
+
+    if (laplog_queue_cnt == LAPLOG_QUEUE)  return;  // EEPROM not ready
+
+    // first lap of new session
+    if (laplog_new & tbit) {
+	laplog_new &= (u8)~tbit;
+	laplog_session[tid] = (u8)((laplog_session[tid] + 1) & LAPLOG_SESSION);
+    }
+
+    e = &laplog_queue[(laplog_queue_pos + laplog_queue_cnt) & (LAPLOG_QUEUE - 1)];
+    e->session = (u8)(laplog_session[tid] | (tid << 7));
+    e->time = (u16)(t > 0xffff ? 0xffff : t);
+    laplog_queue_cnt++;
+}
+
+
+// write one queued lap to EEPROM when EEPROM is not busy, called
+//   periodically from INPUT task
+void menu_timer_laplog_flush(void) {
+    laplog_entry_s *e;
+
+    if (!laplog_queue_cnt) {
+	// lock EEPROM after last entry
+	eeprom_idle();
+	return;
+    }
+    e = &laplog_queue[laplog_queue_pos];
+    e->seq = laplog_seq;
+    if (!eeprom_write_laplog(laplog_pos, e))  return;
+    laplog_pos = laplog_next(laplog_pos);
+    laplog_seq = laplog_seq_next(laplog_seq);
+    laplog_queue_pos = (u8)((laplog_queue_pos + 1) & (LAPLOG_QUEUE - 1));
+    laplog_queue_cnt--;
+}
+
+
+// find newest entry of lap log and restore laps of last session
+//   of each timer, lap timer is set to total time of that laps
+void menu_timer_laplog_init(void) {
+    u8 i, idx, tid, type;
+    laplog_entry_s *e;
+
+    // find newest entry, next entry is not following it
+    laplog_seq = 1;
+    for (i = 0; i < LAPLOG_ENTRIES; i++) {
+	e = laplog_entry(i);
+	if (!e->seq)  continue;
+	if (laplog_entry(laplog_next(i))->seq == laplog_seq_next(e->seq))
+	    continue;
+	laplog_pos = laplog_next(i);
+	laplog_seq = laplog_seq_next(e->seq);
+	break;
+    }
+
+    for (tid = 0; tid < TIMER_NUM; tid++) {
+	// last session of this timer, walk from oldest entry
+	laplog_new |= (u8)(1 << tid);
+	idx = laplog_pos;
+	for (i = LAPLOG_ENTRIES; i; i--) {
+	    e = laplog_entry(idx);
+	    if (e->seq && (e->session >> 7) == tid) {
+		laplog_session[tid] = (u8)(e->session & LAPLOG_SESSION);
+		laplog_new &= (u8)~(1 << tid);
+	    }
+	    idx = laplog_next(idx);
+	}
+
+	// restore lap times and statistics only to timers with lap times,
+	//   timer itself starts from zero, restored laps are counted
+	//   to total and average
+	type = TIMER_TYPE(tid);
+	if (laplog_new & (u8)(1 << tid) ||
+	    (type != TIMER_LAP && type != TIMER_DOWN))  continue;
+	for (i = LAPLOG_ENTRIES; i; i--) {
+	    e = laplog_entry(idx);
+	    if (e->seq && e->session == (u8)(laplog_session[tid] | (tid << 7))) {
+		timer_lap_add(tid, e->time);
+		timer_lap_done[tid] += e->time;
+	    }
+	    idx = laplog_next(idx);
+	}
+    }
+}
+
+
+// read timer value in ms including ms from last timer step, together
+//   with time_ms at the same moment
+static u32 timer_read_ms(u8 tid, u16 *now) {
+    menu_timer_s *pt = &menu_timer[tid];
+    u16 tsec;
+    u8  thdr;
+    u8  sub = 0;
+    sim();
+    tsec = pt->sec;
+    thdr = pt->hdr;
+    // timers are stepped at even 5ms steps
+    if (menu_timer_running & (u8)(1 << tid))
+	sub = (u8)((time_5ms & 1 ? 5 : 0) + time_1ms);
+    *now = time_ms;
+    rim();
+    return (u32)tsec * 1000 + (u16)thdr * 10 + sub;
+}
+
+
+// move timer forward by ms (time from key press to its processing)
+static void timer_advance(menu_timer_s *pt, u16 ms) {
+    u16 hdr = ms / 10;
+    sim();
+    hdr += pt->hdr;
+    pt->sec += hdr / 100;
+    pt->hdr = (u8)(hdr % 100);
+    rim();
+}
+
+
 // save lap time
 static void timer_lap_time_save(u8 tid) {
     menu_timer_s *pt;
     u8  *plc = &timer_lap_count[tid];
-    u16 tsec;
+    u16 tsec, now, age;
     u8  thdr;
-    u8  lap;
-
-    // read timer
-    pt = &menu_timer[tid];
-    TIMER_READ(pt, tsec, thdr);
-
-    // find lap position where to save it
-    //   if over, start from zero
-    lap = *plc;
-    if (lap == TIMER_MAX_LAPCNT)  return;  // too many laps
-    while (lap >= TIMER_MAX_LAPS)  lap -= TIMER_MAX_LAPS;
+    u32 t, tot;
+
+    if (*plc == TIMER_MAX_LAPCNT)  return;  // too many laps
+
+    if (TIMER_TYPE(tid) == TIMER_LAP) {
+	// lap timer value at time of key press, MENU task can get to
+	//   this key later
+	t = timer_read_ms(tid, &now);
+	age = now - menu_key_time;
+	t = t > age ? t - age : 0;
+	// to 0.01s, lap time is difference to previous lap
+	t = (t + 5) / 10;
+	if (t < timer_lap_total[tid])  t = timer_lap_total[tid];
+	tot = t;
+	t -= timer_lap_total[tid];
+	timer_lap_total[tid] = tot;
+    }
+    else {
+	// read timer
+	pt = &menu_timer[tid];
+	TIMER_READ(pt, tsec, thdr);
+	t = (u32)tsec * 100 + thdr;
+    }
 
     // save value
-    pt = &timer_lap_time[tid][lap];
-    pt->sec = tsec;
-    pt->hdr = thdr;
-
-    // increment lap count
-    (*plc)++;
+    timer_lap_add(tid, t);
+    laplog_append(tid, t);
 }
 
 
@@ -516,6 +845,8 @@ void kf_menu_timer_start(u8 *id, u8 *param, u8 flags, s16 *pv) {
 	    // when not running, start it
 	    if (!(menu_timer_running & tbit)) {
 		menu_timer_running |= tbit;
+		// start counting from key press
+		timer_advance(pt, (u16)(time_ms - menu_key_time));
 		next_timer_sec_display[tid] = 0;	// display running value
 		break;
 	    }
@@ -537,9 +868,9 @@ void kf_menu_timer_start(u8 *id, u8 *param, u8 flags, s16 *pv) {
 	    next_timer_sec[tid] = time_sec + 3;
 	    // max 255 laps
 	    if (timer_lap_count[tid] == TIMER_MAX_LAPCNT)  break;
-	    if (++timer_lap_count[tid] == menu_timer_alarm[tid]) {
+	    if (++timer_lap_count[tid] == pt->alarm) {
 		// alarm when number of laps elapsed
-		buzzer_on(60, 0, 1);
+		buzzer_play(buzzer_alarm, 1);
 	    }
 	    break;
 
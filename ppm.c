@@ -45,13 +45,18 @@
 
 // channel variables
 u8 channels;			// number of channels
-static u8 channels2;		// number of channels * 2 (for compare in ppm_interrupt, it is quicker this way)
+u8 channels2;			// number of channels * 2 (for compare in ppm_interrupt, it is quicker this way)
+u8 channels2_next;		// channels2 from next frame
 u8 ppm_channel2;		// next PPM channel to send (0 is SYNC), step 2
 _Bool ppm_enabled;		// set to 1 when first ppm values were computed
 // PPM values computed for direct seting to TIM3 registers
 // 0 is SYNC pulse length and then channels 1-...
 u8 ppm_values[2*(MAX_CHANNELS + 1)];  // as bytes for ppm_interrupt and timer_interrupt
 
+// offsets of channels at ppm_values, channels can be remapped to
+//   other output positions
+static u8 ppm_offset[MAX_CHANNELS + 1];
+
 // variables for planning when start frame and when awake CALC
 u8 ppm_timer;			// timer incremented every 1ms
 u8 ppm_start;			// when to start servo pulses
@@ -62,22 +67,42 @@ u8 ppm_frame_length;		// last length of ppm frame
 
 
 
-// set number of channels
+// set number of channels, CALC computes values for them from now and
+//   timer_interrupt uses them from frame start after next ppm_calc_sync,
+//   so PPM signal is not stopped, only SYNC length is changed
 void ppm_set_channels(u8 n) {
     if (channels == n)  return;		// did not changed
 
-    // disable PPM generation till new values will not be set
-    ppm_enabled = 0;
-    BRES(TIM3_CR1, 0);	// disable timer
-    BSET(PD_ODR, 0);	// set PPM pin to 1
-    // set values for timer wakeups
+    channels = n;
+    if (ppm_enabled)  return;
+
+    // first call, set values for timer wakeups
     ppm_start = ppm_timer;				// not now, CALC will compute new one
     ppm_calc_awake = (u8)(ppm_start + PPM_SYNC_LENGTH_MIN);	// SYNC signal min length
     ppm_end = ppm_calc_awake;
+    channels2 = channels2_next = (u8)(n << 1);
     ppm_enabled = 1;
+}
 
-    channels = n;
-    channels2 = (u8)(n << 1);  // also 2* value for compare in ppm_interrupt
+
+// prepare offsets of channels from model output map, when map is not
+//   valid for actual number of channels, channels are not remapped
+void ppm_set_map(void) {
+    u8 i, pos, used = 0;
+
+    for (i = 1; i <= channels; i++) {
+	pos = (u8)((cm.ppm_out_map[(u8)(i - 1) >> 1] >> (((i - 1) & 1) << 2))
+		   & 0x0f);
+	if (!pos)  pos = i;
+	if (pos > channels || (used & (u8)(1 << (pos - 1))))  break;
+	used |= (u8)(1 << (pos - 1));
+	ppm_offset[i] = (u8)(pos << 1);
+    }
+    if (i <= channels) {
+	// not valid
+	for (i = 1; i <= channels; i++)
+	    ppm_offset[i] = (u8)(i << 1);
+    }
 }
 
 
@@ -135,11 +160,12 @@ void ppm_init(void) {
 // set new value for given servo channel (1-...), value in 0.1usec (for
 //   eliminating more rounding errors)
 static u32 ppm_microsecs01;
+static u32 ppm_microsecs01_last;	// of last frame
 void ppm_set_value(u8 channel, u16 microsec01) {
     ppm_microsecs01 += microsec01;
     // ARR must be set to computed value - 1, that is why we are substracting
     //   5000, it is quicker way to "add 5000" and then substract 1 from result
-    *(u16 *)(&ppm_values[(u8)(channel << 1)]) =
+    *(u16 *)(&ppm_values[ppm_offset[channel]]) =
 	(u16)(((u32)microsec01 * PPM_MUL_SERVO - PPM(500)) / PPM(1000));
 }
 
@@ -147,7 +173,35 @@ void ppm_set_value(u8 channel, u16 microsec01) {
 // calculate length of SYNC signal (substract previous channel values)
 // also sets flag for ppm_interrupt to use new values
 // also starts TIM3 at first call
+static void ppm_frame(void);
 void ppm_calc_sync(void) {
+    // values of all channels are set, commit their number
+    channels2_next = (u8)(channels << 1);
+    ppm_microsecs01_last = ppm_microsecs01;
+    ppm_frame();
+}
+
+// plan next frame with values and number of channels of last frame
+void ppm_hold_frame(void) {
+    ppm_microsecs01 = ppm_microsecs01_last;
+    ppm_frame();
+}
+
+// FLASH programming stops CPU with interrupts for up to 6ms, so it must
+//   not be done while servo pulses are sent (ppm_interrupt would not
+//   set next pulses and timer would repeat last one)
+// SYNC signal has TIM3 period at least PPM_SAFE_FRAME_LENGTH - servo pulses
+//   (at least 7ms), so when started at its begin, only next frame start
+//   (timer_interrupt) is delayed, SYNC is longer and no pulse is changed
+// ppm_channel2 is 4 only during SYNC (channel 1 is set to preload)
+void ppm_wait_sync(void) {
+    if (!ppm_enabled)  return;
+    // let other tasks run till servo pulses, then wait for SYNC start
+    while (ppm_channel2 == 4)  pause();
+    while (*(volatile u8 *)&ppm_channel2 != 4);
+}
+
+static void ppm_frame(void) {
     u16 ppm_start_last = ppm_start;
     u16 ppm_end16 = ppm_end;
     u16 ppm_tmp;
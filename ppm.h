@@ -40,6 +40,8 @@
 
 // actual number of channels
 extern u8 channels;
+extern u8 channels2;		// number of channels * 2 of actual frame
+extern u8 channels2_next;	// channels2 from next frame
 extern u8 ppm_channel2;		// next PPM channel to send (0 is SYNC), step 2
 extern _Bool ppm_enabled;	// set to 1 when first ppm values were computed
 extern u8 ppm_values[];		// as bytes for ppm_interrupt and timer_interrupt
@@ -53,6 +55,9 @@ extern u8 ppm_frame_length;	// last length of ppm frame
 // set actual number of channels
 extern void ppm_set_channels(u8 n);
 
+// set output positions of channels from model config
+extern void ppm_set_map(void);
+
 // set channel value to microsec01 (in 0.1 microseconds)
 extern void ppm_set_value(u8 channel, u16 microsec01);
 // macro for converting microseconds to ppm_set_value() microsec01
@@ -61,6 +66,10 @@ extern void ppm_set_value(u8 channel, u16 microsec01);
 // after setting each actual channel value, call this to calculate
 //   length of sync signal
 extern void ppm_calc_sync(void);
+// repeat last frame, used instead of setting values and ppm_calc_sync
+extern void ppm_hold_frame(void);
+// wait for start of SYNC signal, before stopping CPU by FLASH programming
+extern void ppm_wait_sync(void);
 
 
 #endif
@@ -0,0 +1,225 @@
+/*
+    ppm_in - capturing PPM signal from trainer or head tracker
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+    rising edges at pin PD7 generate TLI interrupt, it stores time of
+    edge (1ms counter + TIM2 counter) to cyclic buffer, only interrupt
+    writes head and only CALC task writes tail, so no locking is needed
+
+    CALC task decodes edges at start of each cycle, pulse widths are
+    channel values, gap longer than PPM_IN_SYNC is SYNC signal, frame
+    is accepted when all pulses are valid and it has the same number
+    of channels as previous one
+
+    TLI is interrupting also timer_interrupt, so timer_interrupt marks
+    incrementing of time_ms to determine if it is already incremented
+*/
+
+
+#include <string.h>
+#include "ppm_in.h"
+#include "ppm.h"
+#include "timer.h"
+
+
+// pulse limits in TIM2 ticks
+#define US(us)  ((u16)((u32)(us) * PPM_IN_TICKS_MS / 1000))
+#define PPM_IN_MIN	US(700)
+#define PPM_IN_MAX	US(2300)
+#define PPM_IN_SYNC	US(3000)
+#define PPM_IN_MIN_CHANNELS  2
+// no valid frame for this time (ms) is signal lost
+#define PPM_IN_TIMEOUT	100
+// waiting for SYNC signal
+#define PPM_IN_NOSYNC	0xff
+
+
+// cyclic buffer of edges, size must be power of 2
+#define PPM_IN_RING	16
+typedef struct {
+    u8	ms;		// low byte of time_ms
+    u16	cnt;		// TIM2 counter
+} ppm_in_edge_s;
+@near static ppm_in_edge_s ppm_in_ring[PPM_IN_RING];
+static volatile u8 ppm_in_head;	// written only by interrupt
+static u8 ppm_in_tail;		// written only by CALC
+static _Bool ppm_in_on;
+
+// decoded values
+@near s16 ppm_in[PPM_IN_CHANNELS];
+u8 ppm_in_channels;
+
+// decoder state
+static u8  last_ms;		// last edge
+static u16 last_cnt;
+static u8  valid_ms;		// time of last valid frame
+static u8  frame_idx;		// next channel in frame
+static u8  frame_len;		// number of channels in previous frame
+@near static s16 frame[PPM_IN_CHANNELS];
+
+
+
+
+// read actual time, overflow of TIM2 can be not counted to time_ms yet
+@inline static u8 ppm_in_time(u16 *cnt) {
+    u8 hi = TIM2_CNTRH;		// reading high byte latches low byte
+    u8 lo = TIM2_CNTRL;
+    u8 ms = (u8)time_ms;
+
+    // overflow before reading counter and timer_interrupt not called
+    //   yet or called but time_ms still not incremented
+    if ((BCHK(TIM2_SR1, 0) && hi < hi8(PPM_IN_TICKS_MS / 2)) ||
+	(time_ms_incr && ms == time_ms_old))
+	ms++;
+    *cnt = (u16)((u16)hi << 8 | lo);
+    return ms;
+}
+
+
+// TLI interrupt at rising edge of PD7
+@interrupt void ppm_in_interrupt(void) {
+    u16 cnt;
+    u8 ms = ppm_in_time(&cnt);
+    u8 head = ppm_in_head;
+    u8 next = (u8)((head + 1) & (PPM_IN_RING - 1));
+
+    // when full, this edge is lost and frame will be invalid
+    if (next == ppm_in_tail)  return;
+    ppm_in_ring[head].ms = ms;
+    ppm_in_ring[head].cnt = cnt;
+    ppm_in_head = next;
+}
+
+
+// enable/disable capturing
+void ppm_in_set(u8 on) {
+    if (on == ppm_in_on)  return;	// did not changed
+
+    sim();
+    if (on) {
+	BSET(EXTI_CR2, 2);	// TLI at rising edge
+	IO_IP(D, 7);		// input with pull-up
+	BSET(PD_CR2, 7);	// with interrupt
+    }
+    else  BRES(PD_CR2, 7);
+    ppm_in_tail = ppm_in_head;
+    rim();
+
+    ppm_in_on = on;
+    ppm_in_channels = 0;
+    frame_len = 0;
+    frame_idx = PPM_IN_NOSYNC;
+    memset(ppm_in, 0, sizeof(ppm_in));
+}
+
+
+
+
+// TIM2 ticks from last edge, long times are returned as 0xffff
+static u16 ppm_in_ticks(u8 ms, u16 cnt) {
+    u8 dms = (u8)(ms - last_ms);
+    if (dms >= 7)  return 0xffff;
+    return (u16)(dms * PPM_IN_TICKS_MS + cnt - last_cnt);
+}
+
+
+// end of frame, check it and use its values
+static void ppm_in_frame_end(void) {
+    u8 n = frame_idx;
+
+    frame_idx = PPM_IN_NOSYNC;		// next frame after SYNC
+    if (n < PPM_IN_MIN_CHANNELS || n > PPM_IN_CHANNELS)  return;
+    if (n != frame_len) {
+	// number of channels changed, wait for next frame
+	frame_len = n;
+	return;
+    }
+    memcpy(ppm_in, frame, n * sizeof(s16));
+    memset(&ppm_in[n], 0, (PPM_IN_CHANNELS - n) * sizeof(s16));
+    ppm_in_channels = n;
+    valid_ms = last_ms;
+}
+
+
+// process one edge
+void ppm_in_edge(u8 ms, u16 cnt) {
+    u16 width = ppm_in_ticks(ms, cnt);
+    s16 val;
+
+    last_ms = ms;
+    last_cnt = cnt;
+
+    // SYNC signal, start of new frame
+    if (width >= PPM_IN_SYNC) {
+	ppm_in_frame_end();
+	frame_idx = 0;
+	return;
+    }
+
+    // bad pulse or too much channels, wait for next SYNC
+    if (frame_idx >= PPM_IN_CHANNELS ||
+	width < PPM_IN_MIN || width > PPM_IN_MAX) {
+	frame_idx = PPM_IN_NOSYNC;
+	return;
+    }
+
+    // to 0.1 microseconds and -5000..5000 range
+    val = (s16)((u32)width * PPM(1000) / PPM_IN_TICKS_MS) - PPM(1500);
+    if (val < PPM(-500))       val = PPM(-500);
+    else if (val > PPM(500))   val = PPM(500);
+    frame[frame_idx++] = val;
+}
+
+
+// check actual time for end of frame and signal timeout
+void ppm_in_check(u8 ms, u16 cnt) {
+    // no pulse can be longer, do not wait for end of SYNC
+    if (frame_idx != PPM_IN_NOSYNC && ppm_in_ticks(ms, cnt) > PPM_IN_MAX)
+	ppm_in_frame_end();
+
+    // signal lost
+    if (ppm_in_channels && (u8)(ms - valid_ms) > PPM_IN_TIMEOUT) {
+	ppm_in_channels = 0;
+	frame_len = 0;
+	memset(ppm_in, 0, sizeof(ppm_in));
+    }
+}
+
+
+// process edges from cyclic buffer
+void ppm_in_update(void) {
+    u16 cnt;
+    u8 ms;
+    ppm_in_edge_s *e;
+
+    if (!ppm_in_on)  return;
+
+    while (ppm_in_tail != ppm_in_head) {
+	e = &ppm_in_ring[ppm_in_tail];
+	ppm_in_edge(e->ms, e->cnt);
+	ppm_in_tail = (u8)((ppm_in_tail + 1) & (PPM_IN_RING - 1));
+    }
+
+    sim();	// timer_interrupt cannot change time now
+    ms = ppm_in_time(&cnt);
+    rim();
+    ppm_in_check(ms, cnt);
+}
+
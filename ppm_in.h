@@ -0,0 +1,53 @@
+/*
+    ppm_in include file
+    Copyright (C) 2011 Pavel Semerad
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _PPM_IN_INCLUDED
+#define _PPM_IN_INCLUDED
+
+
+#include "gt3b.h"
+
+
+// max number of input channels, first PPM_IN_MIX can be mix sources
+#define PPM_IN_CHANNELS  8
+#define PPM_IN_MIX	 4
+
+// TIM2 ticks in 1ms, it is time base of edge timestamps
+#define PPM_IN_TICKS_MS  (KHZ / 2)
+
+
+// input channel values -5000..5000, 0 when not received
+extern s16 ppm_in[PPM_IN_CHANNELS];
+// number of channels in last valid frame, 0 when no signal
+extern u8 ppm_in_channels;
+
+// enable/disable input interrupt at PD7
+extern void ppm_in_set(u8 on);
+
+// process captured edges, called at start of each CALC cycle
+extern void ppm_in_update(void);
+
+// decoder, they are not touching hardware, so they can be fed by
+//   synthetic timestamps (ms and TIM2 ticks) when testing
+extern void ppm_in_edge(u8 ms, u16 cnt);
+extern void ppm_in_check(u8 ms, u16 cnt);
+
+
+#endif
+
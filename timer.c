@@ -54,11 +54,17 @@ void timer_init(void) {
 volatile u16 time_sec;
 volatile u8  time_5ms;
 volatile u8  time_1ms;
+volatile u16 time_ms;
+volatile u8  time_ms_old;	// time_ms before increment
+volatile _Bool time_ms_incr;	// time_ms is just incrementing
 static u16 menu_delay;		// timer for delay in MENU task
 
 
 // interrupt every 1ms
 @interrupt void timer_interrupt(void) {
+    // PPM input interrupt can come anytime, mark incrementing of time_ms
+    time_ms_old = (u8)time_ms;
+    time_ms_incr = 1;
     BRES(TIM2_SR1, 0);  // erase interrupt flag
 
     // read ADC values every 1ms, it had enought time to end conversion
@@ -67,6 +73,9 @@ static u16 menu_delay;		// timer for delay in MENU task
     // process PPM start, CALC awake
     if (ppm_enabled) {
 	if (++ppm_timer == ppm_start) {
+	    // frame start, values of all channels are already set, so
+	    //   new number of channels can be used
+	    channels2 = channels2_next;
 	    // load values for channel1 to registers and do timer update event
 	    TIM3_PSCR = PPM_PSC_SERVO;
 	    TIM3_CCR2H = hi8(PPM_300US_SERVO);
@@ -81,7 +90,12 @@ static u16 menu_delay;		// timer for delay in MENU task
 	    awake(CALC);
     }
 
+    // ABS pulses
+    if (cm.abs_type)  calc_abs_tick();
+
     // increment 1ms steps
+    time_ms++;
+    time_ms_incr = 0;
     if (++time_1ms < 5)  return;
     time_1ms = 0;
 
@@ -102,7 +116,7 @@ static u16 menu_delay;		// timer for delay in MENU task
 
 	// inactivity timer
 	if (inactivity && !(--inactivity))
-	    buzzer_on(20, 255, BUZZER_MAX);	// expired, buzzer on
+	    buzzer_play(buzzer_inactivity, BUZZER_MAX);	// expired
 
     }
 
@@ -119,95 +133,43 @@ static u16 menu_delay;		// timer for delay in MENU task
 	}
     }
 
-    // buzzer timer
-    if (buzzer_running) {
-	if (!--buzzer_cnt) {
-	    // counted down to 0
-	    if (BUZZER_CHK) {
-		// was state 1
-		BUZZER0;
-		if (--buzzer_count) {
-		    buzzer_cnt = buzzer_cnt_off;
+    // buzzer timer, to next pattern byte
+    if (buzzer_running && !--buzzer_cnt)  buzzer_step();
+
+    // menu timers, only every 10ms
+    // alarms are only flagged, they are handled in INPUT task
+    if (menu_timer_running && !(time_5ms & 0b00000001)) {
+	menu_timer_s *pt = menu_timer;
+	u8 tbit = 1;
+	u8 tid;
+	for (tid = 0; tid < TIMER_NUM; tid++, pt++, tbit <<= 1) {
+	    if (!(menu_timer_running & tbit))  continue;
+	    if (pt->down) {
+		// down timer
+		if (pt->hdr) {
+		    pt->hdr--;
+		    continue;
 		}
-		else {
-		    buzzer_running = 0;
+		if (--pt->sec) {
+		    pt->hdr = 99;
+		    continue;
 		}
+		// at zero, change timer to upcounting, disable up-count alarm
+		pt->down = 0;
+		pt->alarm = 0;
 	    }
 	    else {
-		// was state 0
-		BUZZER1;
-		buzzer_cnt = buzzer_cnt_on;
+		// up timer
+		if (++pt->hdr < 100)  continue;
+		pt->hdr = 0;
+		if (++pt->sec != pt->alarm)  continue;
 	    }
+	    // flag alarm
+	    menu_timer_alarmed |= tbit;
+	    menu_timer_alarm_new |= tbit;
 	}
     }
 
-    // menu timers
-#define PROCESS_TIMER(tid) \
-    if (menu_timer_running & (u8)(1 << tid)) { \
-	if (!(time_5ms & 0b00000001)) {  /* only every 10ms */ \
-	    if (menu_timer_direction & (u8)(1 << tid)) { \
-		/* down timer */ \
-		if (menu_timer[tid].hdr) \
-		    menu_timer[tid].hdr--; \
-		else { \
-		    /* hdr is zero */ \
-		    if (--menu_timer[tid].sec == 0) { \
-			/* trigger alarm */ \
-			buzzer_cnt_on = buzzer_cnt = 60; \
-			buzzer_cnt_off = 0; \
-			buzzer_count = 1; \
-			BUZZER1; \
-			buzzer_running = 1; \
-			/* backlight on */ \
-			if (!lcd_bck_on) { \
-			    LCD_BCK1; \
-			    lcd_bck_count = 5; \
-			    lcd_bck_on = 1; \
-			} \
-			else if (lcd_bck_count < 5)  lcd_bck_count = 5; \
-			/* change timer to upcounting, disable up-count alarm */ \
-			menu_timer_alarmed |= (u8)(1 << tid); \
-			menu_timer_direction &= (u8)~(u8)(1 << tid); \
-			menu_timer_alarm[tid] = 0; \
-			/* switch main screen */ \
-			menu_main_screen = MS_TIMER ## tid ; \
-			awake(MENU); \
-		    } \
-		    else \
-			menu_timer[tid].hdr = 99; \
-		} \
-	    } \
-	    else { \
-		/* up timer */ \
-		if (++menu_timer[tid].hdr == 100) { \
-		    menu_timer[tid].hdr = 0; \
-		    if (++menu_timer[tid].sec == menu_timer_alarm[tid]) { \
-			/* trigger alarm */ \
-			buzzer_cnt_on = buzzer_cnt = 60; \
-			buzzer_cnt_off = 0; \
-			buzzer_count = 1; \
-			BUZZER1; \
-			buzzer_running = 1; \
-			/* backlight on */ \
-			if (!lcd_bck_on) { \
-			    LCD_BCK1; \
-			    lcd_bck_count = 5; \
-			    lcd_bck_on = 1; \
-			} \
-			else if (lcd_bck_count < 5)  lcd_bck_count = 5; \
-			/* flag alarm */ \
-			menu_timer_alarmed |= (u8)(1 << tid); \
-			/* switch main screen */ \
-			menu_main_screen = MS_TIMER ## tid ; \
-			awake(MENU); \
-		    } \
-		} \
-	    } \
-	} \
-    }
-    PROCESS_TIMER(0);
-    PROCESS_TIMER(1);
-
     // wakeup INPUT task
     awake(INPUT);
 
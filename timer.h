@@ -27,6 +27,11 @@
 // current time from power on, in seconds and 5ms steps
 extern volatile u16 time_sec;
 extern volatile u8  time_5ms;
+extern volatile u8  time_1ms;
+// free running 1ms counter for time stamps
+extern volatile u16 time_ms;
+extern volatile u8  time_ms_old;	// for PPM input interrupt
+extern volatile _Bool time_ms_incr;
 
 
 // delay in task MENU - will be interrupted by buttons/ADC
@@ -37,12 +37,14 @@ struct intr_vector {
 extern void _stext();     /* startup routine */
 extern void ppm_interrupt(void);
 extern void timer_interrupt(void);
+extern void lcd_interrupt(void);
+extern void ppm_in_interrupt(void);
 
 
 struct intr_vector const _vectab[] = {
 	INTR_VEC(_stext),	/* reset */
 	INTR_DEFAULT,		/* trap  */
-	INTR_DEFAULT,		/* 0  TLI - External top level interrupt */
+	INTR_VEC(ppm_in_interrupt),/* 0  TLI - External top level interrupt */
 	INTR_DEFAULT,		/* 1  AWU - Auto wakeup from halt */
 	INTR_DEFAULT,		/* 2  CLK - Clock controller */
 	INTR_DEFAULT,		/* 3  EXTI0 - Port A external interrupts */
@@ -65,7 +67,7 @@ struct intr_vector const _vectab[] = {
 	INTR_DEFAULT,		/* 20 UART2 - Tx complete */
 	INTR_DEFAULT,		/* 21 UART2 - Receiver register DATA FULL */
 	INTR_DEFAULT,		/* 22 ADC1 - end of conversion */
-	INTR_DEFAULT,		/* 23 TIM4 - update/overflow */
+	INTR_VEC(lcd_interrupt),/* 23 TIM4 - update/overflow */
 	INTR_DEFAULT,		/* 24 Flash - EOP/WR_PG_DIS */
 	INTR_DEFAULT,		/* 25 */
 	INTR_DEFAULT,		/* 26 */